@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/utils/parser.h"
+
+// Generator of reproducible inputs for benchmarks. Every kind of data is produced from one seed by mt19937_64 with
+// own distributions, because distributions of the standard library differ between implementations. Data is written
+// by chunks, so size of output doesn't depend on memory
+
+const int ERROR_CODE = 111;
+
+static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+class Random {
+public:
+    explicit Random(uint64_t seed) : engine_(seed){};
+
+    // Uniform number from 0 to n - 1
+    uint64_t Below(uint64_t n) {
+        return engine_() % n;
+    }
+
+    // Uniform number from 0 to 1
+    double Unit() {
+        return static_cast<double>(engine_() >> 11) / static_cast<double>(1ull << 53);
+    }
+
+    uint64_t Bits() {
+        return engine_();
+    }
+
+private:
+    std::mt19937_64 engine_;
+};
+
+// Vocabulary of made-up words and cumulative probabilities of Zipf's law for them. Guide table keeps the first
+// rank for every of equal parts of [0, 1), so a word is found by a short linear scan instead of a binary search
+class ZipfWords {
+public:
+    static constexpr size_t WORDS_COUNT = 4096;
+    static constexpr size_t GUIDE_SIZE = 1 << 14;
+
+    explicit ZipfWords(Random& random) {
+        static const std::array<const char*, 16> SYLLABLES = {"ar", "ch", "co", "de", "en", "fi", "le", "ma",
+                                                              "ne", "or", "pa", "re", "st", "ti", "un", "ve"};
+        double sum = 0;
+        for (size_t rank = 0; rank < WORDS_COUNT; ++rank) {
+            std::string word;
+            size_t syllables = 1 + random.Below(4);
+            for (size_t i = 0; i < syllables; ++i) {
+                word += SYLLABLES[random.Below(SYLLABLES.size())];
+            }
+            words_.push_back(word);
+            sum += 1.0 / static_cast<double>(rank + 1);
+            cumulative_.push_back(sum);
+        }
+        for (double& probability : cumulative_) {
+            probability /= sum;
+        }
+        cumulative_.back() = 1;
+        size_t rank = 0;
+        for (size_t part = 0; part < GUIDE_SIZE; ++part) {
+            while (cumulative_[rank] < static_cast<double>(part) / GUIDE_SIZE) {
+                ++rank;
+            }
+            guide_[part] = rank;
+        }
+    }
+
+    const std::string& Next(Random& random) const {
+        double unit = random.Unit();
+        size_t rank = guide_[static_cast<size_t>(unit * GUIDE_SIZE)];
+        while (cumulative_[rank] < unit) {
+            ++rank;
+        }
+        return words_[rank];
+    }
+
+private:
+    std::vector<std::string> words_;
+    std::vector<double> cumulative_;
+    std::array<size_t, GUIDE_SIZE> guide_ = {};
+};
+
+// Source of one kind of data, that appends roughly chunk size of bytes on every call
+using Source = std::function<void(std::string&)>;
+
+static Source RandomSource(Random& random) {
+    return [&random](std::string& chunk) {
+        while (chunk.size() < CHUNK_SIZE) {
+            uint64_t bits = random.Bits();
+            chunk.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+        }
+    };
+}
+
+// Sentences of words with Zipf frequencies
+static Source TextSource(Random& random) {
+    auto words = std::make_shared<ZipfWords>(random);
+    return [&random, words](std::string& chunk) {
+        while (chunk.size() < CHUNK_SIZE) {
+            size_t length = 5 + random.Below(15);
+            for (size_t i = 0; i < length; ++i) {
+                chunk += words->Next(random);
+                chunk += i + 1 < length ? ' ' : '.';
+            }
+            chunk += random.Below(8) == 0 ? '\n' : ' ';
+        }
+    };
+}
+
+// Lines of service log with increasing timestamps, levels, workers, paths and latencies
+static Source LogSource(Random& random) {
+    static const std::array<const char*, 4> LEVELS = {"INFO", "INFO", "WARN", "ERROR"};
+    static const std::array<const char*, 6> PATHS = {"/api/v1/files", "/api/v1/upload", "/api/v1/status",
+                                                     "/health",       "/api/v2/search", "/static/app.js"};
+    auto milliseconds = std::make_shared<uint64_t>(1700000000000ull);
+    return [&random, milliseconds](std::string& chunk) {
+        while (chunk.size() < CHUNK_SIZE) {
+            *milliseconds += random.Below(50);
+            uint64_t seconds = *milliseconds / 1000;
+            std::string line = std::to_string(seconds) + "." + std::to_string(1000 + *milliseconds % 1000).substr(1);
+            line += " ";
+            line += LEVELS[random.Below(8) == 0 ? 2 + random.Below(2) : 0];
+            line += " [worker-" + std::to_string(random.Below(16)) + "] request id=";
+            line += std::to_string(random.Bits() % 1000000000);
+            line += " path=";
+            line += PATHS[random.Below(PATHS.size())];
+            line += " status=" + std::to_string(random.Below(20) == 0 ? 500 : 200);
+            line += " latency_ms=" + std::to_string(1 + random.Below(30) * random.Below(10)) + "\n";
+            chunk += line;
+        }
+    };
+}
+
+// Records of 8 bytes: increasing 32-bit time and two 16-bit samples of slowly changing signals, little-endian
+static Source NumericSource(Random& random) {
+    auto state = std::make_shared<std::array<int64_t, 3>>(std::array<int64_t, 3>{0, 1000, -2000});
+    return [&random, state](std::string& chunk) {
+        auto& [time, first, second] = *state;
+        auto append = [&chunk](uint64_t value, size_t bytes) {
+            for (size_t i = 0; i < bytes; ++i) {
+                chunk += static_cast<char>(value >> (8 * i));
+            }
+        };
+        while (chunk.size() < CHUNK_SIZE) {
+            time += 10 + static_cast<int64_t>(random.Below(3));
+            first = std::clamp<int64_t>(first + static_cast<int64_t>(random.Below(41)) - 20, -32768, 32767);
+            second = std::clamp<int64_t>(second + static_cast<int64_t>(random.Below(201)) - 100, -32768, 32767);
+            append(static_cast<uint64_t>(time), 4);
+            append(static_cast<uint64_t>(first), 2);
+            append(static_cast<uint64_t>(second), 2);
+        }
+    };
+}
+
+static Source MakeSource(const std::string& kind, Random& random) {
+    if (kind == "random") {
+        return RandomSource(random);
+    }
+    if (kind == "text") {
+        return TextSource(random);
+    }
+    if (kind == "logs") {
+        return LogSource(random);
+    }
+    if (kind == "numeric") {
+        return NumericSource(random);
+    }
+    throw std::invalid_argument("Unknown kind of data \"" + kind + "\", please, provide random, text, logs, numeric "
+                                "or tree.");
+}
+
+// Write size bytes from source into file
+static void WriteFile(const std::filesystem::path& path, uint64_t size, const Source& source) {
+    std::ofstream output(path, std::ios::binary | std::ios::out);
+    if (output.fail()) {
+        throw std::runtime_error("Can't create file \"" + path.string() + "\".");
+    }
+    std::string chunk;
+    while (size > 0) {
+        if (chunk.empty()) {
+            source(chunk);
+        }
+        size_t count = std::min<uint64_t>(size, chunk.size());
+        output.write(chunk.data(), static_cast<std::streamsize>(count));
+        chunk.erase(0, count);
+        size -= count;
+    }
+}
+
+// Directory tree of many small files of text and logs, which sizes are spread from zero to twice the average.
+// Files are placed into subdirectories of 100 files
+static void WriteTree(const std::filesystem::path& path, uint64_t size, size_t files_count, Random& random) {
+    Source text = TextSource(random);
+    Source logs = LogSource(random);
+    uint64_t average_size = size / files_count;
+    for (size_t file = 0; file < files_count; ++file) {
+        std::filesystem::path directory = path / ("dir" + std::to_string(file / 100));
+        std::filesystem::create_directories(directory);
+        uint64_t file_size = average_size > 0 ? random.Below(2 * average_size + 1) : 0;
+        WriteFile(directory / ("file" + std::to_string(file) + (file % 2 == 0 ? ".txt" : ".log")), file_size,
+                  file % 2 == 0 ? text : logs);
+    }
+}
+
+// Get positive number from argument with exactly one value, return 0 if the value is invalid
+static uint64_t NumberArgument(const Parser& parser, const std::string& name) {
+    if (!parser.HasArgument(name) || parser[name].Size() != 1) {
+        return 0;
+    }
+    std::string value = parser[name].First();
+    if (value.empty() || value.size() > 12 || value.find_first_not_of("0123456789") != std::string::npos) {
+        return 0;
+    }
+    return std::stoull(value);
+}
+
+static int Help() {
+    std::cerr << "Type \"generate_corpus --kind kind --size kb --output path\" to write kb kilobytes of generated data"
+              << std::endl;
+    std::cerr << "Kinds: random (uniform bytes), text (words with Zipf frequencies), logs (lines of service log), "
+                 "numeric (records of time and two signals), tree (directory of small text and log files)"
+              << std::endl;
+    std::cerr << "Add \"--seed number\" to change generated data (1 by default)" << std::endl;
+    std::cerr << "Add \"--files count\" to set count of files of tree (1000 by default)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Parser parser(argc, argv, {{'h', "help"}}, {"help", "kind", "size", "output", "seed", "files"});
+        if (parser.HasArgument("help")) {
+            return Help();
+        }
+        if (!parser.HasArgument("kind") || parser["kind"].Size() != 1 || !parser.HasArgument("output") ||
+            parser["output"].Size() != 1) {
+            throw std::invalid_argument("Please, provide one kind of data and one output path.");
+        }
+        uint64_t size = NumberArgument(parser, "size") * 1024;
+        if (size == 0) {
+            throw std::invalid_argument("After --size, please, provide one positive size in kilobytes.");
+        }
+        uint64_t seed = parser.HasArgument("seed") ? NumberArgument(parser, "seed") : 1;
+        if (seed == 0) {
+            throw std::invalid_argument("After --seed, please, provide one positive number.");
+        }
+        size_t files_count = parser.HasArgument("files") ? NumberArgument(parser, "files") : 1000;
+        if (files_count == 0) {
+            throw std::invalid_argument("After --files, please, provide one positive count of files.");
+        }
+
+        Random random(seed);
+        std::string kind = parser["kind"].First();
+        if (kind == "tree") {
+            WriteTree(parser["output"].First(), size, files_count, random);
+        } else {
+            WriteFile(parser["output"].First(), size, MakeSource(kind, random));
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << std::endl << "For more information type:" << std::endl;
+        std::cerr << "generate_corpus -h (--help)" << std::endl;
+        return ERROR_CODE;
+    }
+}
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../src/canonical_code.h"
+#include "../src/long_code.h"
+#include "../src/utils/bit_reader.h"
+#include "../src/utils/bit_writer.h"
+#include "../src/utils/counter.h"
+#include "../src/utils/parser.h"
+#include "../src/utils/perf_counters.h"
+#include "../src/utils/priority_queue.h"
+#include "../src/utils/trie.h"
+
+// Microbenchmarks of building blocks of the archiver. Every benchmark is a round over prepared data, that is repeated
+// until it takes at least the minimal time. Result is time per operation and bytes of data per CPU cycle, where
+// cycles are counted by hardware counters or, if the kernel forbids them, by the time stamp counter of x86
+
+const int ERROR_CODE = 111;
+
+static constexpr size_t DATA_SIZE = 1 << 20;
+
+// Keep value, so that the compiler doesn't throw away computation of it
+template <typename T>
+void KeepValue(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Cycles of this thread and whether they are real CPU cycles
+static std::pair<uint64_t, bool> ReadCycles() {
+    std::optional<CounterValues> counters = PerfCounters::Read();
+    if (counters.has_value() && counters->cycles > 0) {
+        return {counters->cycles, true};
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    return {__rdtsc(), false};
+#else
+    return {0, false};
+#endif
+}
+
+struct Benchmark {
+    std::string name;
+    size_t ops;    // Operations in one round
+    size_t bytes;  // Bytes of data processed by one round
+    std::function<void()> round;
+};
+
+class Runner {
+public:
+    Runner(std::chrono::milliseconds min_time, std::string filter) : min_time_(min_time), filter_(std::move(filter)){};
+
+    void Run(const Benchmark& benchmark) {
+        if (benchmark.name.find(filter_) == std::string::npos) {
+            return;
+        }
+        benchmark.round();  // Warm up caches and branch predictors
+
+        size_t rounds = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto [start_cycles, real_cycles] = ReadCycles();
+        auto elapsed = std::chrono::steady_clock::duration::zero();
+        while (elapsed < min_time_) {
+            benchmark.round();
+            ++rounds;
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        uint64_t cycles = ReadCycles().first - start_cycles;
+
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        double ops = static_cast<double>(rounds * benchmark.ops);
+        double bytes = static_cast<double>(rounds * benchmark.bytes);
+        std::cout << std::left << std::setw(36) << benchmark.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << ns / ops << " ns/op" << std::setw(10) << bytes / ns * 1e9 / (1 << 20)
+                  << " MB/s";
+        if (cycles > 0) {
+            std::cout << std::setw(10) << std::setprecision(3) << bytes / static_cast<double>(cycles) << " bytes/cycle"
+                      << (real_cycles ? "" : " (tsc)");
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    std::chrono::milliseconds min_time_;
+    std::string filter_;
+};
+
+// Bytes with given count of distinct symbols, where frequency of symbol of rank r is proportional to 1 / (r + 1)^skew
+static std::string MakeData(size_t size, size_t symbols_count, double skew, uint64_t seed) {
+    std::vector<double> cumulative;
+    double sum = 0;
+    for (size_t rank = 0; rank < symbols_count; ++rank) {
+        sum += 1 / std::pow(static_cast<double>(rank + 1), skew);
+        cumulative.push_back(sum);
+    }
+    std::mt19937_64 random(seed);
+    std::string data(size, 0);
+    for (char& c : data) {
+        double unit = static_cast<double>(random() >> 11) / static_cast<double>(1ull << 53) * sum;
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), unit) - cumulative.begin();
+        c = static_cast<char>(std::min(rank, symbols_count - 1));
+    }
+    return data;
+}
+
+static Counter<CharT> CountData(const std::string& data) {
+    Counter<CharT> counter;
+    for (char c : data) {
+        counter.Add(static_cast<unsigned char>(c));
+    }
+    counter.Add(BLOCK_END);
+    return counter;
+}
+
+static void AddBitBenchmarks(std::vector<Benchmark>& benchmarks, const std::string& random_data) {
+    for (size_t width : {1, 4, 8, 9, 16, 32}) {
+        auto stream = std::make_shared<std::istringstream>(random_data);
+        auto reader = std::make_shared<BitReader>(*stream);
+        benchmarks.push_back({"BitReader::Get/" + std::to_string(width), random_data.size() * 8 / width,
+                              random_data.size(), [stream, reader, width] {
+                                  reader->Reset();
+                                  uint64_t value = 0;
+                                  while (reader->Get(value, width)) {
+                                      KeepValue(value);
+                                  }
+                              }});
+    }
+    for (size_t width : {1, 4, 8, 9, 16, 32}) {
+        std::vector<uint64_t> values;
+        std::mt19937_64 random(width);
+        for (size_t i = 0; i < DATA_SIZE * 8 / width; ++i) {
+            values.push_back(random() & ((uint64_t{1} << width) - 1));
+        }
+        benchmarks.push_back({"BitWriter::Write/" + std::to_string(width), values.size(), DATA_SIZE,
+                              [values = std::move(values), width] {
+                                  StringBitWriter writer;
+                                  for (uint64_t value : values) {
+                                      writer.Write(value, width);
+                                  }
+                                  writer.Complete();
+                                  KeepValue(writer.ByteCount());
+                              }});
+    }
+}
+
+static void AddCodeBenchmarks(std::vector<Benchmark>& benchmarks, const std::string& text_data) {
+    benchmarks.push_back({"Counter::Process", text_data.size(), text_data.size(), [&text_data] {
+                              Counter<unsigned char> counter;
+                              counter.Process(text_data);
+                              KeepValue(counter[' ']);
+                          }});
+
+    static constexpr size_t QUEUE_SIZE = 1 << 12;
+    std::vector<uint64_t> keys;
+    std::mt19937_64 random(1);
+    for (size_t i = 0; i < QUEUE_SIZE; ++i) {
+        keys.push_back(random());
+    }
+    benchmarks.push_back({"PriorityQueue::Push+Pop", 2 * QUEUE_SIZE, 2 * QUEUE_SIZE * sizeof(uint64_t),
+                          [keys = std::move(keys)] {
+                              PriorityQueue<uint64_t> queue;
+                              for (uint64_t key : keys) {
+                                  queue.Push(key);
+                              }
+                              while (!queue.Empty()) {
+                                  KeepValue(queue.Pop());
+                              }
+                          }});
+
+    // Code is built once per block, so its bytes are bytes of the block, that it codes
+    struct Distribution {
+        std::string name;
+        size_t symbols_count;
+        double skew;
+    };
+    static constexpr size_t BLOCK_SIZE = 1 << 16;
+    for (const auto& [name, symbols_count, skew] : {Distribution{"uniform", 256, 0}, Distribution{"zipf", 256, 1},
+                                                    Distribution{"skewed", 256, 3}, Distribution{"sparse", 16, 1}}) {
+        auto counter = std::make_shared<Counter<CharT>>(CountData(MakeData(BLOCK_SIZE, symbols_count, skew, 1)));
+        benchmarks.push_back({"CanonicalCodeGenerator/" + name, 1, BLOCK_SIZE, [counter] {
+                                  CanonicalCodeGenerator<CharT> code(*counter);
+                                  KeepValue(code.Size());
+                              }});
+    }
+
+    // Encoded text is decoded bit by bit like in the stream format, trie is built once outside of rounds
+    Counter<CharT> counter = CountData(text_data);
+    CanonicalCodeGenerator<CharT> code(counter);
+    StringBitWriter table_writer;
+    WriteCodeTable(table_writer, code);
+    table_writer.Complete();
+    std::istringstream table_stream(table_writer.Str());
+    BitReader table_reader(table_stream);
+    auto trie = std::make_shared<Trie<CharT>>(BuildTrie(ReadCodeTable(table_reader)));
+
+    StringBitWriter writer;
+    for (char c : text_data) {
+        writer.Write(code[static_cast<unsigned char>(c)]);
+    }
+    writer.Write(code[BLOCK_END]);
+    writer.Complete();
+    auto stream = std::make_shared<std::istringstream>(writer.Str());
+    auto reader = std::make_shared<BitReader>(*stream);
+    benchmarks.push_back({"Trie::Trace decoding", text_data.size(), text_data.size(), [stream, reader, trie] {
+                              reader->Reset();
+                              trie->ResetTrace();
+                              bool bit = false;
+                              while (reader->Get(bit) && trie->Trace(bit)) {
+                                  if (trie->IsTraceLeaf()) {
+                                      if (trie->TraceValue() == BLOCK_END) {
+                                          break;
+                                      }
+                                      KeepValue(trie->TraceValue());
+                                      trie->ResetTrace();
+                                  }
+                              }
+                          }});
+
+    static constexpr size_t CODES_COUNT = 1 << 12;
+    static constexpr size_t CODE_SIZE = 12;
+    benchmarks.push_back({"LongCode::Push+Pop", 2 * CODES_COUNT * CODE_SIZE, CODES_COUNT * CODE_SIZE / 8, [] {
+                              LongCode code;
+                              for (size_t i = 0; i < CODES_COUNT; ++i) {
+                                  for (size_t bit = 0; bit < CODE_SIZE; ++bit) {
+                                      code.Push(bit % 2 == 1);
+                                  }
+                                  for (size_t bit = 0; bit < CODE_SIZE; ++bit) {
+                                      KeepValue(code.Pop());
+                                  }
+                              }
+                          }});
+    benchmarks.push_back({"LongCode::operator++", CODES_COUNT, CODES_COUNT * CODE_SIZE / 8, [] {
+                              LongCode code(CODE_SIZE);
+                              for (size_t i = 0; i < CODES_COUNT; ++i) {
+                                  ++code;
+                              }
+                              KeepValue(code[0]);
+                          }});
+    benchmarks.push_back({"LongCode::operator<<", CODES_COUNT, CODES_COUNT * CODE_SIZE / 8, [] {
+                              for (size_t i = 0; i < CODES_COUNT; ++i) {
+                                  LongCode code(CODE_SIZE / 2);
+                                  code << CODE_SIZE / 2;
+                                  KeepValue(code.Size());
+                              }
+                          }});
+    benchmarks.push_back({"LongCode::operator==", CODES_COUNT, CODES_COUNT * CODE_SIZE / 8, [] {
+                              LongCode first(CODE_SIZE);
+                              LongCode second(CODE_SIZE);
+                              for (size_t i = 0; i < CODES_COUNT; ++i) {
+                                  KeepValue(first == second);
+                              }
+                          }});
+}
+
+int Help() {
+    std::cerr << "Type \"micro_bench\" to run all microbenchmarks" << std::endl;
+    std::cerr << "Add \"--filter text\" to run only benchmarks, which names contain text" << std::endl;
+    std::cerr << "Add \"--min-time ms\" to repeat every benchmark at least ms milliseconds (200 by default)"
+              << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Parser parser(argc, argv, {{'h', "help"}}, {"help", "filter", "min-time"});
+        if (parser.HasArgument("help")) {
+            return Help();
+        }
+        std::string filter = parser.HasArgument("filter") && parser["filter"].Size() == 1 ? parser["filter"].First()
+                                                                                          : "";
+        size_t min_time = 200;
+        if (parser.HasArgument("min-time")) {
+            std::string value = parser["min-time"].Size() == 1 ? parser["min-time"].First() : "";
+            if (value.empty() || value.size() > 6 || value.find_first_not_of("0123456789") != std::string::npos) {
+                throw std::invalid_argument("After --min-time, please, provide one time in milliseconds.");
+            }
+            min_time = std::stoul(value);
+        }
+
+        std::string random_data = MakeData(DATA_SIZE, 256, 0, 1);
+        std::string text_data = MakeData(DATA_SIZE, 64, 1, 2);
+        std::vector<Benchmark> benchmarks;
+        AddBitBenchmarks(benchmarks, random_data);
+        AddCodeBenchmarks(benchmarks, text_data);
+
+        std::cout << "Cycles are counted by "
+                  << (PerfCounters::Available() ? "hardware counters" : "time stamp counter") << std::endl;
+        Runner runner(std::chrono::milliseconds(min_time), filter);
+        for (const auto& benchmark : benchmarks) {
+            runner.Run(benchmark);
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << std::endl << "For more information type:" << std::endl;
+        std::cerr << "micro_bench -h (--help)" << std::endl;
+        return ERROR_CODE;
+    }
+}
@@ -0,0 +1,18 @@
+#include <cstring>
+
+#include "decompressor.h"
+
+// Exception of damaged archive is thrown by every decoder, so it is compiled apart from the rest of decompressor, and
+// tools may use decoders without it
+
+// Constructor of ArchiveDamagedError
+Decompressor::ArchiveDamagedError::ArchiveDamagedError(const std::string& description) {
+    std::string full_description = "Archive is damaged, can't decompress it (" + description + ").";
+    description_ = new char[full_description.size() + 1];
+    std::strcpy(description_, full_description.c_str());
+}
+
+// Return more information about ArchiveDamagedError exception
+const char* Decompressor::ArchiveDamagedError::what() const noexcept {
+    return description_;
+}
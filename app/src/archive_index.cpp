@@ -0,0 +1,147 @@
+#include "archive_index.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "decompressor.h"
+
+// Check header of archive
+bool ArchiveIndex::IsIndexed(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary | std::ios::in);
+    BitReader bit_reader(stream);
+
+    uint32_t magic = 0;
+    uint8_t version = 0;
+    return bit_reader.Get(magic, 32) && bit_reader.Get(version, 8) && magic == HEADER_MAGIC &&
+           version >= FIRST_VERSION && version <= VERSION;
+}
+
+void ArchiveIndex::WriteHeader(BitWriter& bit_writer, uint8_t version) {
+    bit_writer.Write(HEADER_MAGIC, 32);
+    bit_writer.Write(version, 8);
+}
+
+// Read index of archive using offset from its trailer
+ArchiveIndex ArchiveIndex::Read(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary | std::ios::in);
+    if (stream.fail()) {
+        throw FileBitReader::FileNotExists(path);
+    }
+
+    stream.seekg(0, std::ios::end);
+    uint64_t archive_size = stream.tellg();
+    if (archive_size < HEADER_SIZE + TRAILER_SIZE) {
+        throw Decompressor::ArchiveDamagedError("Can't find archive index");
+    }
+
+    // Read trailer
+    std::string trailer(TRAILER_SIZE, '\0');
+    stream.seekg(static_cast<std::streamoff>(archive_size - TRAILER_SIZE));
+    stream.read(trailer.data(), TRAILER_SIZE);
+    std::istringstream trailer_stream(trailer);
+    BitReader trailer_reader(trailer_stream);
+
+    // Read version from header
+    ArchiveIndex index;
+    std::string header(HEADER_SIZE, '\0');
+    stream.seekg(0);
+    stream.read(header.data(), HEADER_SIZE);
+    std::istringstream header_stream(header);
+    BitReader header_reader(header_stream);
+    uint32_t magic = 0;
+    header_reader.Get(magic, 32);
+    header_reader.Get(index.version_, 8);
+    if (magic != HEADER_MAGIC || index.version_ < FIRST_VERSION || index.version_ > VERSION) {
+        throw Decompressor::ArchiveDamagedError("Unknown archive format");
+    }
+
+    trailer_reader.Get(index.offset_, 64);
+    trailer_reader.Get(magic, 32);
+    if (magic != TRAILER_MAGIC || index.offset_ < HEADER_SIZE || index.offset_ > archive_size - TRAILER_SIZE) {
+        throw Decompressor::ArchiveDamagedError("Can't find archive index");
+    }
+
+    // Read entries
+    std::string data(archive_size - TRAILER_SIZE - index.offset_, '\0');
+    stream.seekg(static_cast<std::streamoff>(index.offset_));
+    stream.read(data.data(), static_cast<std::streamsize>(data.size()));
+    std::istringstream data_stream(data);
+    BitReader bit_reader(data_stream);
+
+    uint32_t entries_count = 0;
+    if (!bit_reader.Get(entries_count, 32)) {
+        throw Decompressor::ArchiveDamagedError("Can't read archive index");
+    }
+    for (uint32_t i = 0; i < entries_count; ++i) {
+        IndexEntry entry;
+        uint16_t name_size = 0;
+        if (!bit_reader.Get(name_size, 16)) {
+            throw Decompressor::ArchiveDamagedError("Can't read archive index");
+        }
+        for (uint16_t j = 0; j < name_size; ++j) {
+            char c = 0;
+            if (!bit_reader.Get(c, 8)) {
+                throw Decompressor::ArchiveDamagedError("Can't read archive index");
+            }
+            entry.name += c;
+        }
+        if (!bit_reader.Get(entry.raw_size, 64) || !bit_reader.Get(entry.offset, 64) ||
+            !bit_reader.Get(entry.size, 64) || (index.version_ > FIRST_VERSION && !bit_reader.Get(entry.skip, 64))) {
+            throw Decompressor::ArchiveDamagedError("Can't read archive index");
+        }
+        if (entry.offset + entry.size > index.offset_) {
+            throw Decompressor::ArchiveDamagedError("Entry is out of archive");
+        }
+        index.entries_.push_back(entry);
+    }
+
+    return index;
+}
+
+// Write index and trailer
+void ArchiveIndex::Write(BitWriter& bit_writer) const {
+    bit_writer.Write(static_cast<uint32_t>(entries_.size()), 32);
+    for (const auto& entry : entries_) {
+        bit_writer.Write(static_cast<uint16_t>(entry.name.size()), 16);
+        for (char c : entry.name) {
+            bit_writer.Write(c, 8);
+        }
+        bit_writer.Write(entry.raw_size, 64);
+        bit_writer.Write(entry.offset, 64);
+        bit_writer.Write(entry.size, 64);
+        if (version_ > FIRST_VERSION) {
+            bit_writer.Write(entry.skip, 64);
+        }
+    }
+
+    bit_writer.Write(offset_, 64);
+    bit_writer.Write(TRAILER_MAGIC, 32);
+}
+
+void ArchiveIndex::Add(const IndexEntry& entry) {
+    entries_.push_back(entry);
+}
+
+std::vector<IndexEntry>& ArchiveIndex::Entries() {
+    return entries_;
+}
+
+const std::vector<IndexEntry>& ArchiveIndex::Entries() const {
+    return entries_;
+}
+
+uint64_t ArchiveIndex::Offset() const {
+    return offset_;
+}
+
+void ArchiveIndex::SetOffset(uint64_t offset) {
+    offset_ = offset;
+}
+
+uint8_t ArchiveIndex::Version() const {
+    return version_;
+}
+
+void ArchiveIndex::SetVersion(uint8_t version) {
+    version_ = version;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/bit_reader.h"
+#include "utils/bit_writer.h"
+
+// Entry of indexed archive
+struct IndexEntry {
+    std::string name;
+    uint64_t raw_size = 0;  // Size of original file
+    uint64_t offset = 0;    // Offset of the first block of entry in archive
+    uint64_t size = 0;      // Total size of entry blocks
+    uint64_t skip = 0;      // Position of entry in decoded data of its blocks, that are shared by solid group
+};
+
+// Index of entries, that is stored at the end of indexed archive.
+// Indexed archive consists of header, blocks of entries, index and trailer with offset of index. New entries are
+// appended by writing their blocks over the old index and writing the new index after them
+class ArchiveIndex {
+public:
+    static constexpr uint32_t HEADER_MAGIC = 0x00415243;   // "\0ARC", legacy archives never start with zero byte
+    static constexpr uint8_t FIRST_VERSION = 1;  // Index of the first version has no positions of entries in blocks
+    static constexpr uint8_t VERSION = 2;
+    static constexpr size_t HEADER_SIZE = 5;
+    static constexpr uint32_t TRAILER_MAGIC = 0x41524349;  // "ARCI"
+    static constexpr size_t TRAILER_SIZE = 12;
+
+    ArchiveIndex() : offset_(HEADER_SIZE), version_(VERSION){};
+
+    static bool IsIndexed(const std::string& path);
+    static ArchiveIndex Read(const std::string& path);
+    static void WriteHeader(BitWriter& bit_writer, uint8_t version = VERSION);
+
+    void Write(BitWriter& bit_writer) const;
+
+    void Add(const IndexEntry& entry);
+
+    std::vector<IndexEntry>& Entries();
+    const std::vector<IndexEntry>& Entries() const;
+
+    uint64_t Offset() const;
+    void SetOffset(uint64_t offset);
+
+    uint8_t Version() const;
+    void SetVersion(uint8_t version);
+
+private:
+    std::vector<IndexEntry> entries_;
+    uint64_t offset_;  // Offset of index, that is the end of entries blocks
+    uint8_t version_;  // Version of archive format, index is written in it
+};
@@ -1,126 +1,464 @@
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
+#include "archive_index.h"
 #include "compressor.h"
 #include "decompressor.h"
+#include "estimator.h"
+#include "report.h"
 #include "utils/parser.h"
+#include "utils/progress.h"
 #include "utils/round.h"
+#include "utils/stats.h"
+#include "utils/thread_pool.h"
 #include "utils/timer.h"
 
 const int ERROR_CODE = 111;
 
-inline int Program(const Parser& parser) {
-    // User didn't write any arguments
-    if (!parser.HasArgument("compress") && !parser.HasArgument("decompress") && !parser.HasArgument("help")) {
-        std::cerr << "Provide one of the archiver modes." << std::endl;
-        std::cerr << "For more information type:" << std::endl;
-        std::cerr << "archiver -h (--help)" << std::endl;
-        return ERROR_CODE;
+// Get positive number not greater than max from argument with exactly one value, return 0 if the value is invalid
+inline size_t NumberArgument(const Parser& parser, const std::string& name, size_t max) {
+    if (parser[name].Size() != 1) {
+        return 0;
+    }
+    std::string value = parser[name].First();
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        return 0;
+    }
+    // Digits are added while the number is in range, so it can't overflow
+    size_t number = 0;
+    for (char digit : value) {
+        number = number * 10 + (digit - '0');
+        if (number > max) {
+            return 0;
+        }
     }
+    return number;
+}
 
-    // User wrote -c (--compress)
-    if (parser.HasArgument("compress") && !parser.HasArgument("decompress") && !parser.HasArgument("help")) {
-        if (parser["compress"].Size() >= 2) {
-            std::vector<std::string> files = parser["compress"].SubArray(1);
+// Get count of worker threads from --threads argument, return 0 if the argument is invalid
+inline size_t ThreadsCount(const Parser& parser) {
+    if (!parser.HasArgument("threads")) {
+        return ThreadPool::DefaultThreadsCount();
+    }
+    return NumberArgument(parser, "threads", ThreadPool::MAX_THREADS_COUNT);
+}
 
-            Timer clock;
-            Compressor compressor(files, parser["compress"].First());
+// Stats to measure stages, if user wrote --stats, --counters or --report-json
+inline Stats* StatsArgument(const Parser& parser, Stats& stats) {
+    if (parser.HasArgument("report-json") && parser["report-json"].Size() != 1) {
+        throw std::invalid_argument("After --report-json, please, provide one path of report.");
+    }
+    if (parser.HasArgument("counters")) {
+        stats.EnableCounters();
+    }
+    return parser.HasArgument("stats") || parser.HasArgument("counters") || parser.HasArgument("report-json")
+               ? &stats
+               : nullptr;
+}
 
-            std::cerr << "Compressing started" << std::endl;
+// Print stats and write report of finished run, if user asked for them
+inline void ReportStats(const Parser& parser, const RunReport& report, const Stats& stats) {
+    if (parser.HasArgument("stats") || parser.HasArgument("counters")) {
+        stats.Print(std::cerr);
+    }
+    if (parser.HasArgument("report-json")) {
+        WriteJsonReport(parser["report-json"].First(), report, stats);
+    }
+}
 
-            try {
-                clock.Tick();
-                compressor.Compress();
-                clock.Tock();
-            } catch (...) {
-                std::cerr << std::endl << "Error occur while compressing:" << std::endl;
-                throw;
-            }
+// Progress to print while working, if user wrote --progress. Interval is given in milliseconds
+inline Progress* ProgressArgument(const Parser& parser, std::optional<Progress>& progress) {
+    if (!parser.HasArgument("progress")) {
+        return nullptr;
+    }
+    std::chrono::milliseconds interval = Progress::DEFAULT_INTERVAL;
+    if (!parser["progress"].Empty()) {
+        interval = std::chrono::milliseconds(NumberArgument(parser, "progress", Progress::MAX_INTERVAL.count()));
+        if (interval.count() == 0) {
+            throw std::invalid_argument("After --progress, please, provide interval in milliseconds from 1 to " +
+                                        std::to_string(Progress::MAX_INTERVAL.count()) + ".");
+        }
+    }
+    progress.emplace(std::cerr, interval);
+    return &*progress;
+}
 
-            if (parser["compress"].Size() >= 3) {
-                std::cerr << "Files compressed successfully in " << clock.Duration().count() << "ms." << std::endl;
-            } else {
-                std::cerr << "File compressed successfully in " << clock.Duration().count() << "ms." << std::endl;
-            }
+// Print hint about help message
+inline int HelpHint() {
+    std::cerr << "For more information type:" << std::endl;
+    std::cerr << "archiver -h (--help)" << std::endl;
+    return ERROR_CODE;
+}
 
-            long double compress_percents = -Round((1 - compressor.ResultWeight() / compressor.RawWeight()) * 100, 2);
+// Settings of compression from optional arguments
+inline CompressionOptions GetCompressionOptions(const Parser& parser) {
+    CompressionOptions options;
+    options.indexed = parser.HasArgument("indexed");
+    options.dedup = parser.HasArgument("dedup");
+    options.solid = parser.HasArgument("solid");
+    options.block.order1 = parser.HasArgument("order1");
+    options.block.lz77 =
+        parser.HasArgument("lz77") || parser.HasArgument("lz-window") || parser.HasArgument("lz-effort");
+    if (parser.HasArgument("lz-window")) {
+        options.block.lz77_options.window_bits = NumberArgument(parser, "lz-window", Lz77Options::MAX_WINDOW_BITS);
+        if (options.block.lz77_options.window_bits < Lz77Options::MIN_WINDOW_BITS ||
+            options.block.lz77_options.window_bits > Lz77Options::MAX_WINDOW_BITS) {
+            throw std::invalid_argument("After --lz-window, please, provide binary logarithm of window size from " +
+                                        std::to_string(Lz77Options::MIN_WINDOW_BITS) + " to " +
+                                        std::to_string(Lz77Options::MAX_WINDOW_BITS) + ".");
+        }
+    }
+    options.block.bwt = parser.HasArgument("bwt");
+    options.block.tans = parser.HasArgument("tans");
+    options.block.words = parser.HasArgument("words");
+    options.block.filters = parser.HasArgument("filters");
+    options.block.split = parser.HasArgument("split");
+    if (parser.HasArgument("block-size")) {
+        options.block_size = NumberArgument(parser, "block-size", CompressionOptions::MAX_BLOCK_SIZE / 1024) * 1024;
+        if (options.block_size < CompressionOptions::MIN_BLOCK_SIZE ||
+            options.block_size > CompressionOptions::MAX_BLOCK_SIZE) {
+            throw std::invalid_argument("After --block-size, please, provide size of block in kilobytes from " +
+                                        std::to_string(CompressionOptions::MIN_BLOCK_SIZE / 1024) + " to " +
+                                        std::to_string(CompressionOptions::MAX_BLOCK_SIZE / 1024) + ".");
+        }
+    }
+    if (parser.HasArgument("speed-weight")) {
+        options.block.speed_weight = NumberArgument(parser, "speed-weight", BlockEncoderOptions::MAX_SPEED_WEIGHT);
+        if (options.block.speed_weight == 0 || options.block.speed_weight > BlockEncoderOptions::MAX_SPEED_WEIGHT) {
+            throw std::invalid_argument("After --speed-weight, please, provide percent of size from 1 to " +
+                                        std::to_string(BlockEncoderOptions::MAX_SPEED_WEIGHT) + ".");
+        }
+    }
+    if (parser.HasArgument("lz-effort")) {
+        options.block.lz77_options.effort = NumberArgument(parser, "lz-effort", Lz77Options::MAX_EFFORT);
+        if (options.block.lz77_options.effort == 0) {
+            throw std::invalid_argument("After --lz-effort, please, provide count of checked matches from 1 to " +
+                                        std::to_string(Lz77Options::MAX_EFFORT) + ".");
+        }
+    }
+    return options;
+}
 
-            std::cerr << "Archive saved at \"" << compressor.archive_path
-                      << "\" with total space: " << compressor.ResultWeight() << " (" << compress_percents << "%)."
-                      << std::endl;
-            return 0;
-        } else {
-            std::cerr << "After -c, please, provide archive name and file paths separated by a space." << std::endl;
-            std::cerr << "For more information type:" << std::endl;
-            std::cerr << "archiver -h (--help)" << std::endl;
-            return ERROR_CODE;
+// User wrote -c (--compress)
+inline int Compress(const Parser& parser, ThreadPool& pool) {
+    if (parser["compress"].Size() < 2) {
+        std::cerr << "After -c, please, provide archive name and file paths separated by a space." << std::endl;
+        return HelpHint();
+    }
+
+    std::vector<std::string> files = parser["compress"].SubArray(1);
+
+    Timer clock;
+    Stats stats;
+    std::optional<Progress> progress;
+    Compressor compressor(files, parser["compress"].First(), pool, GetCompressionOptions(parser),
+                          StatsArgument(parser, stats), ProgressArgument(parser, progress));
+
+    std::cerr << "Compressing started" << std::endl;
+
+    try {
+        clock.Tick();
+        if (progress) {
+            progress->Start();
         }
+        compressor.Compress();
+        clock.Tock();
+        if (progress) {
+            progress->Stop();
+        }
+    } catch (...) {
+        std::cerr << std::endl << "Error occur while compressing:" << std::endl;
+        throw;
     }
-    // User wrote -d (--decompress)
-    else if (!parser.HasArgument("compress") && parser.HasArgument("decompress") && !parser.HasArgument("help")) {
-        if (parser["decompress"].Size() == 1) {
-            std::string archive_path = parser["decompress"].First();
-
-            Timer clock;
-            Decompressor decompressor(archive_path);
-
-            std::cerr << "Decompressing started" << std::endl;
-
-            try {
-                clock.Tick();
-                decompressor.Decompress();
-                clock.Tock();
-            } catch (...) {
-                std::cerr << std::endl << "Error occur while decompressing:" << std::endl;
-                throw;
-            }
-
-            if (decompressor.GetFiles().size() >= 2) {
-                std::cerr << "Files decompressed successfully in " << clock.Duration().count() << "ms." << std::endl;
-                std::cerr << "Decompressed files:" << std::endl;
-                for (const auto& file : decompressor.GetFiles()) {
-                    std::cerr << "  - " << file.GetPath() << " (" << file.GetWeight() << ")" << std::endl;
-                }
-            } else {
-                auto file = decompressor.GetFiles().front();
-                std::cerr << "File \"" << file.GetPath() << "\" (" << file.GetWeight() << ") ";
-                std::cerr << "decompressed successfully in " << clock.Duration().count() << "ms." << std::endl;
-            }
-            return 0;
+
+    if (parser["compress"].Size() >= 3) {
+        std::cerr << "Files compressed successfully in " << clock.Duration().count() << "ms." << std::endl;
+    } else {
+        std::cerr << "File compressed successfully in " << clock.Duration().count() << "ms." << std::endl;
+    }
+
+    long double compress_percents = -Round((1 - compressor.ResultWeight() / compressor.RawWeight()) * 100, 2);
+
+    if (compressor.DuplicatesCount() > 0) {
+        std::cerr << "Duplicate files stored once: " << compressor.DuplicatesCount() << "." << std::endl;
+    }
+    std::cerr << "Archive saved at \"" << compressor.archive_path << "\" with total space: "
+              << compressor.ResultWeight() << " (" << compress_percents << "%)." << std::endl;
+    ReportStats(parser,
+                {.mode = "compress",
+                 .archive_path = compressor.archive_path,
+                 .indexed = GetCompressionOptions(parser).NeedsIndex(),
+                 .threads_count = pool.Size(),
+                 .duration_ms = static_cast<uint64_t>(clock.Duration().count())},
+                stats);
+    return 0;
+}
+
+// User wrote -a (--append)
+inline int Append(const Parser& parser, ThreadPool& pool) {
+    if (parser["append"].Size() < 2) {
+        std::cerr << "After -a, please, provide archive name and file paths separated by a space." << std::endl;
+        return HelpHint();
+    }
+
+    std::vector<std::string> files = parser["append"].SubArray(1);
+
+    Timer clock;
+    Stats stats;
+    std::optional<Progress> progress;
+    Compressor compressor(files, parser["append"].First(), pool, GetCompressionOptions(parser),
+                          StatsArgument(parser, stats), ProgressArgument(parser, progress));
+
+    std::cerr << "Appending started" << std::endl;
+
+    try {
+        clock.Tick();
+        if (progress) {
+            progress->Start();
+        }
+        compressor.Append();
+        clock.Tock();
+        if (progress) {
+            progress->Stop();
+        }
+    } catch (...) {
+        std::cerr << std::endl << "Error occur while appending:" << std::endl;
+        throw;
+    }
+
+    if (parser["append"].Size() >= 3) {
+        std::cerr << "Files (" << compressor.RawWeight() << ") appended successfully in " << clock.Duration().count()
+                  << "ms." << std::endl;
+    } else {
+        std::cerr << "File (" << compressor.RawWeight() << ") appended successfully in " << clock.Duration().count()
+                  << "ms." << std::endl;
+    }
+    if (compressor.DuplicatesCount() > 0) {
+        std::cerr << "Duplicate files stored once: " << compressor.DuplicatesCount() << "." << std::endl;
+    }
+    std::cerr << "Archive saved at \"" << compressor.archive_path << "\" with total space: "
+              << compressor.ResultWeight() << "." << std::endl;
+    ReportStats(parser,
+                {.mode = "append",
+                 .archive_path = compressor.archive_path,
+                 .indexed = true,
+                 .threads_count = pool.Size(),
+                 .duration_ms = static_cast<uint64_t>(clock.Duration().count())},
+                stats);
+    return 0;
+}
+
+// User wrote -d (--decompress)
+inline int Decompress(const Parser& parser, ThreadPool& pool) {
+    if (parser["decompress"].Size() != 1) {
+        if (parser["decompress"].Empty()) {
+            std::cerr << "After -d, please, provide archive name." << std::endl;
         } else {
-            if (parser["decompress"].Empty()) {
-                std::cerr << "After -d, please, provide archive name." << std::endl;
-            } else {
-                std::cerr << "After -d, please, provide only archive name." << std::endl;
-            }
-            std::cerr << "For more information type:" << std::endl;
-            std::cerr << "archiver -h (--help)" << std::endl;
-            return ERROR_CODE;
+            std::cerr << "After -d, please, provide only archive name." << std::endl;
         }
+        return HelpHint();
     }
-    // User wrote -h (--help)
-    else if (!parser.HasArgument("compress") && !parser.HasArgument("decompress") && parser.HasArgument("help")) {
-        std::cerr << "Help message:" << std::endl;
-        std::cerr << "Type \"archiver -c archive_path file1 [file2 ...]\" to compress one or multiple files and save "
-                     "compressed archive as archive_path"
-                  << std::endl;
-        std::cerr << "Type \"archiver -d archive_path\" to decompress archive" << std::endl;
-        return 0;
+
+    std::string archive_path = parser["decompress"].First();
+
+    Timer clock;
+    Stats stats;
+    std::optional<Progress> progress;
+    Decompressor decompressor(archive_path, pool, StatsArgument(parser, stats), ProgressArgument(parser, progress));
+
+    std::cerr << "Decompressing started" << std::endl;
+
+    try {
+        clock.Tick();
+        if (progress) {
+            progress->Start();
+        }
+        decompressor.Decompress();
+        clock.Tock();
+        if (progress) {
+            progress->Stop();
+        }
+    } catch (...) {
+        std::cerr << std::endl << "Error occur while decompressing:" << std::endl;
+        throw;
+    }
+
+    if (decompressor.GetFiles().size() >= 2) {
+        std::cerr << "Files decompressed successfully in " << clock.Duration().count() << "ms." << std::endl;
+        std::cerr << "Decompressed files:" << std::endl;
+        for (const auto& file : decompressor.GetFiles()) {
+            std::cerr << "  - " << file.GetPath() << " (" << file.GetWeight() << ")" << std::endl;
+        }
+    } else if (decompressor.GetFiles().size() == 1) {
+        auto file = decompressor.GetFiles().front();
+        std::cerr << "File \"" << file.GetPath() << "\" (" << file.GetWeight() << ") ";
+        std::cerr << "decompressed successfully in " << clock.Duration().count() << "ms." << std::endl;
+    } else {
+        std::cerr << "Archive is empty." << std::endl;
+    }
+    ReportStats(parser,
+                {.mode = "decompress",
+                 .archive_path = archive_path,
+                 .indexed = ArchiveIndex::IsIndexed(archive_path),
+                 .threads_count = pool.Size(),
+                 .duration_ms = static_cast<uint64_t>(clock.Duration().count())},
+                stats);
+    return 0;
+}
+
+// Part of raw size in percents, that is printed like ratio of archive
+inline long double Percents(uint64_t part, uint64_t raw_bytes) {
+    return raw_bytes > 0 ? Round(static_cast<long double>(part) / static_cast<long double>(raw_bytes) * 100, 2) : 0;
+}
+
+// User wrote -e (--estimate)
+inline int Estimate(const Parser& parser, ThreadPool& pool) {
+    if (parser["estimate"].Empty()) {
+        std::cerr << "After -e, please, provide file paths separated by a space." << std::endl;
+        return HelpHint();
+    }
+
+    std::vector<std::string> files = parser["estimate"].SubArray(0);
+
+    Timer clock;
+    Estimator estimator(files, pool, GetCompressionOptions(parser));
+
+    std::cerr << "Estimating started" << std::endl;
+
+    clock.Tick();
+    std::vector<FileEstimate> estimates = estimator.Estimate();
+    clock.Tock();
+
+    uint64_t raw_bytes = 0;
+    uint64_t sampled_bytes = 0;
+    uint64_t archive_bytes = 0;
+    std::cerr << "Estimated files:" << std::endl;
+    for (const auto& estimate : estimates) {
+        std::cerr << "  - " << estimate.path << " (" << Weight(estimate.raw_bytes) << "): ~"
+                  << Weight(estimate.archive_bytes) << " (" << Percents(estimate.archive_bytes, estimate.raw_bytes)
+                  << "%), sampled " << Percents(estimate.sampled_bytes, estimate.raw_bytes) << "%" << std::endl;
+        raw_bytes += estimate.raw_bytes;
+        sampled_bytes += estimate.sampled_bytes;
+        archive_bytes += estimate.archive_bytes;
+    }
+    std::cerr << "Archive is expected to take ~" << Weight(archive_bytes) << " of " << Weight(raw_bytes) << " ("
+              << Percents(archive_bytes, raw_bytes) << "%)." << std::endl;
+    std::cerr << "Compression is expected to take ~" << Estimator::ExpectedMilliseconds(estimates, pool.Size())
+              << "ms with " << pool.Size() << (pool.Size() == 1 ? " thread." : " threads.") << std::endl;
+    std::cerr << "Estimated in " << clock.Duration().count() << "ms by " << Weight(sampled_bytes) << " of samples ("
+              << Percents(sampled_bytes, raw_bytes) << "%)." << std::endl;
+    return 0;
+}
+
+// User wrote -h (--help)
+inline int Help() {
+    std::cerr << "Help message:" << std::endl;
+    std::cerr << "Type \"archiver -c archive_path file1 [file2 ...]\" to compress one or multiple files and save "
+                 "compressed archive as archive_path"
+              << std::endl;
+    std::cerr << "Type \"archiver -a archive_path file1 [file2 ...]\" to append files to indexed archive, archive is "
+                 "created if it doesn't exist"
+              << std::endl;
+    std::cerr << "Type \"archiver -d archive_path\" to decompress archive" << std::endl;
+    std::cerr << "Type \"archiver -e file1 [file2 ...]\" to estimate size of archive and time of compression by a "
+                 "small sample of files, options of compression are taken into account"
+              << std::endl;
+    std::cerr << "Add \"--threads count\" to set count of worker threads (count of hardware threads by default)"
+              << std::endl;
+    std::cerr << "Add \"--stats\" to print wall and CPU time and bytes of every stage per file and in total"
+              << std::endl;
+    std::cerr << "Add \"--counters\" to add cycles per byte, IPC, branch and cache misses of stages from hardware "
+                 "counters to stats"
+              << std::endl;
+    std::cerr << "Add \"--progress [ms]\" to print throughput, ETA and status of files every interval (1000ms by "
+                 "default) while working"
+              << std::endl;
+    std::cerr << "Add \"--report-json path\" to write sizes, ratio, times, throughput, peak memory and codecs of "
+                 "blocks per file and in total as JSON"
+              << std::endl;
+    std::cerr << "Add \"--indexed\" to compress into indexed archive, that allows appending files later" << std::endl;
+    std::cerr << "Add \"--dedup\" to store identical files once, archive is indexed then" << std::endl;
+    std::cerr << "Add \"--solid\" to compress small files together with shared code tables, archive is indexed then"
+              << std::endl;
+    std::cerr << "Add \"--order1\" to try Huffman codes chosen by previous byte for every block, archive is indexed "
+                 "then"
+              << std::endl;
+    std::cerr << "Add \"--lz77\" to try LZ77 matches with previous data for every block, archive is indexed then"
+              << std::endl;
+    std::cerr << "Add \"--lz-window bits\" to search LZ77 matches no further than 2^bits bytes back (16 by default)"
+              << std::endl;
+    std::cerr << "Add \"--lz-effort count\" to check count of previous positions for every LZ77 match (32 by default)"
+              << std::endl;
+    std::cerr << "Add \"--bwt\" to try Burrows-Wheeler transform for every block, archive is indexed then" << std::endl;
+    std::cerr << "Add \"--tans\" to try tANS code instead of Huffman code for every block, archive is indexed then"
+              << std::endl;
+    std::cerr << "Add \"--words\" to try Huffman code of 16-bit words for every block, archive is indexed then"
+              << std::endl;
+    std::cerr << "Add \"--filters\" to try delta filters and byte lanes of records for every block, archive is indexed "
+                 "then"
+              << std::endl;
+    std::cerr << "Add \"--speed-weight percent\" to prefer codecs, that decode faster, at cost of percent of size for "
+                 "every unit of decoding time, archive is indexed then"
+              << std::endl;
+    std::cerr << "Add \"--split\" to split blocks, where statistics of data change, archive is indexed then"
+              << std::endl;
+    std::cerr << "Add \"--block-size kb\" to set size of independently compressed blocks of indexed archive (1024 by "
+                 "default)"
+              << std::endl;
+    return 0;
+}
+
+inline int Program(const Parser& parser) {
+    size_t modes_count = parser.HasArgument("compress") + parser.HasArgument("append") +
+                         parser.HasArgument("decompress") + parser.HasArgument("estimate") + parser.HasArgument("help");
+
+    // User didn't write any arguments
+    if (modes_count == 0) {
+        std::cerr << "Provide one of the archiver modes." << std::endl;
+        return HelpHint();
     }
     // User wrote multiple argument
-    else {
+    if (modes_count > 1) {
         std::cerr << "Provide exactly one of the archiver modes." << std::endl;
-        std::cerr << "For more information type:" << std::endl;
-        std::cerr << "archiver -h (--help)" << std::endl;
-        return ERROR_CODE;
+        return HelpHint();
+    }
+
+    if (parser.HasArgument("help")) {
+        return Help();
+    }
+
+    size_t threads_count = ThreadsCount(parser);
+    if (threads_count == 0) {
+        std::cerr << "After --threads, please, provide number of threads from 1 to " << ThreadPool::MAX_THREADS_COUNT
+                  << "." << std::endl;
+        return HelpHint();
+    }
+    ThreadPool pool(threads_count);
+
+    if (parser.HasArgument("compress")) {
+        return Compress(parser, pool);
+    }
+    if (parser.HasArgument("append")) {
+        return Append(parser, pool);
+    }
+    if (parser.HasArgument("estimate")) {
+        return Estimate(parser, pool);
     }
+    return Decompress(parser, pool);
 }
 
 int main(int argc, char** argv) {
     try {
         // Setup parser arguments for archiver program
-        Parser parser(argc, argv, {{'c', "compress"}, {'d', "decompress"}, {'h', "help"}},
-                      {"compress", "decompress", "help"});
+        Parser parser(argc, argv,
+                      {{'c', "compress"}, {'a', "append"}, {'d', "decompress"}, {'e', "estimate"}, {'h', "help"}},
+                      {"compress", "append", "decompress", "estimate", "help", "threads", "indexed", "dedup", "solid",
+                       "order1", "lz77", "lz-window", "lz-effort", "bwt", "tans", "words", "filters", "split",
+                       "block-size", "speed-weight", "stats", "counters", "report-json", "progress"});
 
         return Program(parser);
     }
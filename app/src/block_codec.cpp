@@ -0,0 +1,951 @@
+#include "block_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "bwt.h"
+#include "canonical_code.h"
+#include "decompressor.h"
+#include "filter.h"
+#include "lz77.h"
+#include "service_symbols.h"
+#include "tans.h"
+#include "utils/bit_window.h"
+#include "word_code.h"
+
+void BlockHeader::Write(BitWriter& bit_writer) const {
+    uint8_t codec_byte = static_cast<uint8_t>(codec) | static_cast<uint8_t>(filter) << FILTER_SHIFT;
+    bit_writer.Write(static_cast<uint8_t>(codec_byte | (compact_tables ? COMPACT_TABLES : 0)), 8);
+    bit_writer.Write(raw_size, 32);
+    bit_writer.Write(size, 32);
+}
+
+BlockHeader BlockHeader::Read(BitReader& bit_reader) {
+    BlockHeader header;
+    uint8_t codec = 0;
+    if (!bit_reader.Get(codec, 8) || !bit_reader.Get(header.raw_size, 32) || !bit_reader.Get(header.size, 32)) {
+        throw Decompressor::ArchiveDamagedError("Can't read block header");
+    }
+    header.compact_tables = codec & COMPACT_TABLES;
+    uint8_t filter = (codec & ~COMPACT_TABLES) >> FILTER_SHIFT;
+    codec &= CODEC_MASK;
+    if (codec >= BLOCK_CODECS_COUNT) {
+        throw Decompressor::ArchiveDamagedError("Unknown block codec");
+    }
+    if (filter >= BLOCK_FILTERS_COUNT) {
+        throw Decompressor::ArchiveDamagedError("Unknown block filter");
+    }
+    header.codec = static_cast<BlockCodec>(codec);
+    header.filter = static_cast<BlockFilter>(filter);
+    return header;
+}
+
+// Contexts of order-1 code are values of the previous byte, the first byte of block follows zero byte
+static constexpr size_t CONTEXTS_COUNT = 1 << FILE_FIXED_CHAR_SIZE;
+
+// Contexts with less symbols always share one code, own table of such context costs more than it saves
+static constexpr size_t MIN_OWN_CONTEXT_COUNT = 256;
+
+// Counts of symbols of block code: bytes and BLOCK_END, that ends every block
+std::vector<size_t> BlockSymbolCounts(const Histogram& counts) {
+    std::vector<size_t> symbol_counts(counts.begin(), counts.end());
+    symbol_counts.resize(BLOCK_END + 1, 0);
+    symbol_counts[BLOCK_END] = 1;
+    return symbol_counts;
+}
+
+// Code needs at least two symbols, the lowest unused symbols are added if there are less
+void AddMissingSymbols(std::vector<size_t>& counts) {
+    counts.resize(std::max<size_t>(counts.size(), 2), 0);
+    size_t symbols_count = std::count_if(counts.begin(), counts.end(), [](size_t count) { return count > 0; });
+    for (size_t c = 0; c < counts.size() && symbols_count < 2; ++c) {
+        if (counts[c] == 0) {
+            counts[c] = 1;
+            ++symbols_count;
+        }
+    }
+}
+
+// Canonical code of symbols with given counts
+CanonicalCodeGenerator<CharT> BuildCode(std::vector<size_t> counts) {
+    AddMissingSymbols(counts);
+    Counter<CharT> counter;
+    for (size_t c = 0; c < counts.size(); ++c) {
+        if (counts[c] > 0) {
+            counter.Add(static_cast<CharT>(c), counts[c]);
+        }
+    }
+    return CanonicalCodeGenerator<CharT>(counter);
+}
+
+// Size of symbols encoded by Huffman code with its compact table in bits. Sizes of codes are found without building
+// canonical code and are saved to code_sizes
+size_t EstimateBitCount(std::vector<size_t> counts, std::vector<size_t>& code_sizes) {
+    AddMissingSymbols(counts);
+    code_sizes = HuffmanCodeSizes(counts);
+
+    size_t bit_count = 0;
+    for (size_t c = 0; c < counts.size(); ++c) {
+        bit_count += counts[c] * code_sizes[c];
+    }
+    return bit_count + CompactCodeTableBitCount(code_sizes);
+}
+
+// Tables of blocks written before compact tables are read in full form
+CodeTable ReadBlockCodeTable(BitReader& bit_reader, const BlockHeader& header, const CodeTable* previous = nullptr) {
+    return header.compact_tables ? ReadCompactCodeTable(bit_reader, previous) : ReadCodeTable(bit_reader);
+}
+
+// Size of data with given counts of bytes in bits by their entropy, without building code. Table of code is estimated
+// by sizes of codes rounded from entropy of every byte, block header is added too
+double EstimateEntropyBitCount(const Histogram& counts) {
+    size_t total = 0;
+    for (size_t count : counts) {
+        total += count;
+    }
+
+    double bit_count = BlockHeader::SIZE * 8;
+    std::vector<size_t> code_sizes(counts.size(), 0);
+    for (size_t c = 0; c < counts.size(); ++c) {
+        if (counts[c] > 0) {
+            double symbol_bit_count = std::log2(static_cast<double>(total) / static_cast<double>(counts[c]));
+            bit_count += static_cast<double>(counts[c]) * symbol_bit_count;
+            code_sizes[c] = std::max<size_t>(1, static_cast<size_t>(std::lround(symbol_bit_count)));
+        }
+    }
+    return bit_count + static_cast<double>(CompactCodeTableBitCount(code_sizes));
+}
+
+// Order-1 model: contexts with enough symbols get own code if it's estimated to be shorter than order-0 code, other
+// contexts share one code
+struct Order1Model {
+    std::vector<Histogram> counts;
+    Histogram shared_counts = {};
+    std::array<bool, CONTEXTS_COUNT> own = {};
+    size_t bit_count = CONTEXTS_COUNT;
+
+    std::vector<CanonicalCodeGenerator<CharT>> codes;  // Own codes in order of contexts, then shared code
+    std::array<size_t, CONTEXTS_COUNT> code_index = {};
+
+    Order1Model(const std::string& data, const std::vector<size_t>& order0_code_sizes) : counts(CONTEXTS_COUNT) {
+        unsigned char previous = 0;
+        for (char c : data) {
+            ++counts[previous][static_cast<unsigned char>(c)];
+            previous = static_cast<unsigned char>(c);
+        }
+
+        std::vector<size_t> code_sizes;
+        for (size_t context = 0; context < CONTEXTS_COUNT; ++context) {
+            size_t context_count = 0;
+            size_t order0_bit_count = 0;
+            for (size_t c = 0; c < counts[context].size(); ++c) {
+                context_count += counts[context][c];
+                order0_bit_count += counts[context][c] * order0_code_sizes[c];
+            }
+            if (context_count >= MIN_OWN_CONTEXT_COUNT) {
+                size_t own_bit_count = EstimateBitCount(BlockSymbolCounts(counts[context]), code_sizes);
+                if (own_bit_count < order0_bit_count) {
+                    own[context] = true;
+                    bit_count += own_bit_count;
+                    continue;
+                }
+            }
+            for (size_t c = 0; c < shared_counts.size(); ++c) {
+                shared_counts[c] += counts[context][c];
+            }
+        }
+        bit_count += EstimateBitCount(BlockSymbolCounts(shared_counts), code_sizes);
+    }
+
+    // Build codes of contexts, when the model is chosen for encoding
+    void BuildCodes() {
+        for (size_t context = 0; context < CONTEXTS_COUNT; ++context) {
+            if (own[context]) {
+                code_index[context] = codes.size();
+                codes.push_back(BuildCode(BlockSymbolCounts(counts[context])));
+            }
+        }
+        for (size_t context = 0; context < CONTEXTS_COUNT; ++context) {
+            if (!own[context]) {
+                code_index[context] = codes.size();
+            }
+        }
+        codes.push_back(BuildCode(BlockSymbolCounts(shared_counts)));
+    }
+};
+
+// LZ77 tokens of block with counts of codes of literals and lengths and of codes of distances
+struct Lz77Model {
+    std::vector<Lz77Token> tokens;
+    std::vector<size_t> literal_counts;  // Literals, BLOCK_END and codes of lengths
+    std::vector<size_t> distance_counts;
+    size_t bit_count = 0;
+
+    Lz77Model(const std::string& data, const Lz77Options& options)
+        : tokens(FindMatches(data, options)),
+          literal_counts(LZ77_LENGTH_BASE + LZ77_LENGTH_CODES, 0),
+          distance_counts(LZ77_DISTANCE_CODES, 0) {
+        literal_counts[BLOCK_END] = 1;
+        for (const auto& token : tokens) {
+            if (token.length == 0) {
+                ++literal_counts[token.distance];
+                continue;
+            }
+            uint32_t code = 0;
+            uint32_t extra = 0;
+            size_t extra_bit_count = 0;
+            BucketCode(token.length - LZ77_MIN_MATCH, code, extra, extra_bit_count);
+            ++literal_counts[LZ77_LENGTH_BASE + code];
+            bit_count += extra_bit_count;
+            BucketCode(token.distance - 1, code, extra, extra_bit_count);
+            ++distance_counts[code];
+            bit_count += extra_bit_count;
+        }
+
+        std::vector<size_t> code_sizes;
+        bit_count += EstimateBitCount(literal_counts, code_sizes) + EstimateBitCount(distance_counts, code_sizes);
+    }
+};
+
+// Burrows-Wheeler transform of block with move-to-front and zero runs coding, its symbols are coded by Huffman code
+struct BwtModel {
+    uint32_t primary_index = 0;
+    std::vector<uint16_t> symbols;
+    std::vector<size_t> counts;  // Symbols and BLOCK_END
+    size_t bit_count = 32;
+
+    explicit BwtModel(const std::string& data) : counts(BLOCK_END + 1, 0) {
+        symbols = MoveToFrontRle(BwtForward(data, primary_index));
+        for (uint16_t symbol : symbols) {
+            ++counts[symbol];
+        }
+        counts[BLOCK_END] = 1;
+
+        std::vector<size_t> code_sizes;
+        bit_count += EstimateBitCount(counts, code_sizes);
+    }
+};
+
+std::string EncodeHuffman(const std::string& data, const CanonicalCodeGenerator<CharT>& canonical_code) {
+    StringBitWriter bit_writer;
+    WriteCompactCodeTable(bit_writer, canonical_code);
+    for (char c : data) {
+        bit_writer.Write(canonical_code[static_cast<unsigned char>(c)]);
+    }
+    bit_writer.Write(canonical_code[BLOCK_END]);
+    bit_writer.Complete();
+    return bit_writer.Str();
+}
+
+// Flags of contexts with own code, tables of codes, then every symbol encoded by code of its context
+std::string EncodeHuffmanOrder1(const std::string& data, const Order1Model& model) {
+    StringBitWriter bit_writer;
+    for (bool own : model.own) {
+        bit_writer.Write(own);
+    }
+    for (size_t i = 0; i < model.codes.size(); ++i) {
+        WriteCompactCodeTable(bit_writer, model.codes[i], i > 0 ? &model.codes[i - 1] : nullptr);
+    }
+
+    unsigned char previous = 0;
+    for (char c : data) {
+        bit_writer.Write(model.codes[model.code_index[previous]][static_cast<unsigned char>(c)]);
+        previous = static_cast<unsigned char>(c);
+    }
+    bit_writer.Write(model.codes[model.code_index[previous]][BLOCK_END]);
+    bit_writer.Complete();
+    return bit_writer.Str();
+}
+
+// Tables of codes of literals and lengths and of distances, then tokens: literal code, or length code, length
+// extra bits, distance code and distance extra bits
+std::string EncodeLz77(const Lz77Model& model) {
+    CanonicalCodeGenerator<CharT> literal_code = BuildCode(model.literal_counts);
+    CanonicalCodeGenerator<CharT> distance_code = BuildCode(model.distance_counts);
+
+    StringBitWriter bit_writer;
+    WriteCompactCodeTable(bit_writer, literal_code);
+    WriteCompactCodeTable(bit_writer, distance_code);
+    for (const auto& token : model.tokens) {
+        if (token.length == 0) {
+            bit_writer.Write(literal_code[static_cast<CharT>(token.distance)]);
+            continue;
+        }
+        uint32_t code = 0;
+        uint32_t extra = 0;
+        size_t extra_bit_count = 0;
+        BucketCode(token.length - LZ77_MIN_MATCH, code, extra, extra_bit_count);
+        bit_writer.Write(literal_code[static_cast<CharT>(LZ77_LENGTH_BASE + code)]);
+        bit_writer.Write(extra, extra_bit_count);
+        BucketCode(token.distance - 1, code, extra, extra_bit_count);
+        bit_writer.Write(distance_code[static_cast<CharT>(code)]);
+        bit_writer.Write(extra, extra_bit_count);
+    }
+    bit_writer.Write(literal_code[BLOCK_END]);
+    bit_writer.Complete();
+    return bit_writer.Str();
+}
+
+// Primary index of transform, table of code, then symbols after move-to-front and zero runs coding
+std::string EncodeBwt(const BwtModel& model) {
+    CanonicalCodeGenerator<CharT> canonical_code = BuildCode(model.counts);
+
+    StringBitWriter bit_writer;
+    bit_writer.Write(model.primary_index, 32);
+    WriteCompactCodeTable(bit_writer, canonical_code);
+    for (uint16_t symbol : model.symbols) {
+        bit_writer.Write(canonical_code[static_cast<CharT>(symbol)]);
+    }
+    bit_writer.Write(canonical_code[BLOCK_END]);
+    bit_writer.Complete();
+    return bit_writer.Str();
+}
+
+// Normalized counts of bytes, then bytes coded by tANS. Size of data is known from header, so there is no end symbol
+std::string EncodeTans(const std::string& data, const TansCounts& counts) {
+    StringBitWriter bit_writer;
+    counts.Write(bit_writer);
+    TansEncoder(counts).Encode(data, bit_writer);
+    bit_writer.Complete();
+    return bit_writer.Str();
+}
+
+// Sparse table of word code, then words coded by it and the last byte of data of odd size
+std::string EncodeWords(const std::string& data, const WordCodeTable& table) {
+    StringBitWriter bit_writer;
+    table.Write(bit_writer);
+    WordEncoder(table).Encode(data, bit_writer);
+    bit_writer.Complete();
+    return bit_writer.Str();
+}
+
+// Decode symbols starting from bit_position till BLOCK_END, decoder is chosen by the previous byte
+std::string DecodeSymbols(const BlockHeader& header, const std::string& data, size_t bit_position,
+                          const std::array<const CanonicalDecoder*, CONTEXTS_COUNT>& decoders) {
+    BitWindow window(data, bit_position);
+
+    std::string result;
+    result.reserve(header.raw_size);
+
+    unsigned char previous = 0;
+    while (true) {
+        size_t code_size = 0;
+        CharT symbol = decoders[previous]->Decode(window.Peek(), code_size);
+        window.Skip(code_size);
+        if (window.Overrun()) {
+            throw Decompressor::ArchiveDamagedError("Block data ends before its end symbol");
+        }
+        if (symbol == BLOCK_END) {
+            break;
+        }
+        if (symbol >= static_cast<CharT>(CONTEXTS_COUNT) || result.size() == header.raw_size) {
+            throw Decompressor::ArchiveDamagedError("Can't decode block char code");
+        }
+        previous = static_cast<unsigned char>(symbol);
+        result += static_cast<char>(previous);
+    }
+
+    if (result.size() != header.raw_size) {
+        throw Decompressor::ArchiveDamagedError("Block size differs from its header");
+    }
+    return result;
+}
+
+std::string DecodeHuffman(const BlockHeader& header, const std::string& data) {
+    std::istringstream stream(data);
+    BitReader bit_reader(stream);
+
+    CodeTable code_table = ReadBlockCodeTable(bit_reader, header);
+    CanonicalDecoder decoder(code_table);
+
+    std::array<const CanonicalDecoder*, CONTEXTS_COUNT> decoders;
+    decoders.fill(&decoder);
+    return DecodeSymbols(header, data, code_table.BitCount(), decoders);
+}
+
+std::string DecodeHuffmanOrder1(const BlockHeader& header, const std::string& data) {
+    std::istringstream stream(data);
+    BitReader bit_reader(stream);
+
+    std::array<bool, CONTEXTS_COUNT> own = {};
+    size_t own_count = 0;
+    for (size_t context = 0; context < CONTEXTS_COUNT; ++context) {
+        if (!bit_reader.Get(own[context])) {
+            throw Decompressor::ArchiveDamagedError("Can't read contexts of block");
+        }
+        own_count += own[context];
+    }
+
+    size_t bit_position = CONTEXTS_COUNT;
+    std::vector<CanonicalDecoder> decoders;
+    CodeTable code_table;
+    for (size_t i = 0; i <= own_count; ++i) {
+        code_table = ReadBlockCodeTable(bit_reader, header, i > 0 ? &code_table : nullptr);
+        bit_position += code_table.BitCount();
+        decoders.emplace_back(code_table);
+    }
+
+    std::array<const CanonicalDecoder*, CONTEXTS_COUNT> context_decoders;
+    size_t own_index = 0;
+    for (size_t context = 0; context < CONTEXTS_COUNT; ++context) {
+        context_decoders[context] = own[context] ? &decoders[own_index++] : &decoders.back();
+    }
+    return DecodeSymbols(header, data, bit_position, context_decoders);
+}
+
+// Read position of value in bucket and get the value
+uint32_t ReadBucketValue(uint32_t code, BitWindow& window) {
+    size_t extra_bit_count = 0;
+    uint32_t value = BucketBase(code, extra_bit_count);
+    if (extra_bit_count > 0) {
+        value += static_cast<uint32_t>(window.Peek() >> (64 - extra_bit_count));
+        window.Skip(extra_bit_count);
+    }
+    return value;
+}
+
+std::string DecodeLz77(const BlockHeader& header, const std::string& data) {
+    std::istringstream stream(data);
+    BitReader bit_reader(stream);
+
+    CodeTable literal_table = ReadBlockCodeTable(bit_reader, header);
+    CodeTable distance_table = ReadBlockCodeTable(bit_reader, header);
+    CanonicalDecoder literal_decoder(literal_table);
+    CanonicalDecoder distance_decoder(distance_table);
+    BitWindow window(data, literal_table.BitCount() + distance_table.BitCount());
+
+    std::string result;
+    result.reserve(header.raw_size);
+
+    while (true) {
+        size_t code_size = 0;
+        CharT symbol = literal_decoder.Decode(window.Peek(), code_size);
+        window.Skip(code_size);
+        if (symbol == BLOCK_END) {
+            break;
+        }
+
+        if (symbol >= 0 && symbol < static_cast<CharT>(CONTEXTS_COUNT) && result.size() < header.raw_size) {
+            result += static_cast<char>(symbol);
+        } else if (symbol >= LZ77_LENGTH_BASE && symbol < static_cast<CharT>(LZ77_LENGTH_BASE + LZ77_LENGTH_CODES)) {
+            size_t length = ReadBucketValue(symbol - LZ77_LENGTH_BASE, window) + LZ77_MIN_MATCH;
+            CharT distance_symbol = distance_decoder.Decode(window.Peek(), code_size);
+            window.Skip(code_size);
+            if (distance_symbol < 0 || distance_symbol >= static_cast<CharT>(LZ77_DISTANCE_CODES)) {
+                throw Decompressor::ArchiveDamagedError("Can't decode block match distance");
+            }
+            size_t distance = ReadBucketValue(distance_symbol, window) + 1;
+            if (distance > result.size() || length > header.raw_size - result.size()) {
+                throw Decompressor::ArchiveDamagedError("Block match is out of block");
+            }
+
+            // Match may overlap itself, so it is copied byte by byte
+            size_t start = result.size() - distance;
+            for (size_t i = 0; i < length; ++i) {
+                result += result[start + i];
+            }
+        } else {
+            throw Decompressor::ArchiveDamagedError("Can't decode block char code");
+        }
+
+        if (window.Overrun()) {
+            throw Decompressor::ArchiveDamagedError("Block data ends before its end symbol");
+        }
+    }
+
+    if (window.Overrun() || result.size() != header.raw_size) {
+        throw Decompressor::ArchiveDamagedError("Block size differs from its header");
+    }
+    return result;
+}
+
+std::string DecodeBwt(const BlockHeader& header, const std::string& data) {
+    std::istringstream stream(data);
+    BitReader bit_reader(stream);
+
+    uint32_t primary_index = 0;
+    if (!bit_reader.Get(primary_index, 32)) {
+        throw Decompressor::ArchiveDamagedError("Can't read primary index of block");
+    }
+    CodeTable code_table = ReadBlockCodeTable(bit_reader, header);
+    CanonicalDecoder decoder(code_table);
+    BitWindow window(data, 32 + code_table.BitCount());
+
+    // Every symbol gives at least one byte, so there are no more symbols than bytes
+    std::vector<uint16_t> symbols;
+    while (true) {
+        size_t code_size = 0;
+        CharT symbol = decoder.Decode(window.Peek(), code_size);
+        window.Skip(code_size);
+        if (window.Overrun()) {
+            throw Decompressor::ArchiveDamagedError("Block data ends before its end symbol");
+        }
+        if (symbol == BLOCK_END) {
+            break;
+        }
+        if (symbol < 0 || symbol >= static_cast<CharT>(BWT_SYMBOLS_COUNT) || symbols.size() == header.raw_size) {
+            throw Decompressor::ArchiveDamagedError("Can't decode block char code");
+        }
+        symbols.push_back(static_cast<uint16_t>(symbol));
+    }
+
+    return BwtInverse(MoveToFrontRleInverse(symbols, header.raw_size), primary_index);
+}
+
+std::string DecodeTans(const BlockHeader& header, const std::string& data) {
+    std::istringstream stream(data);
+    BitReader bit_reader(stream);
+
+    TansCounts counts = TansCounts::Read(bit_reader);
+    return TansDecoder(counts).Decode(data, counts.BitCount(), header.raw_size);
+}
+
+std::string DecodeWords(const BlockHeader& header, const std::string& data) {
+    std::istringstream stream(data);
+    BitReader bit_reader(stream);
+
+    WordCodeTable table = WordCodeTable::Read(bit_reader);
+    return WordDecoder(table).Decode(data, table.BitCount(), header.raw_size);
+}
+
+// Lanes are inner blocks, that can't have lanes themselves
+std::string DecodeLanes(const BlockHeader& header, const std::string& data) {
+    if (data.empty() || data[0] == 0) {
+        throw Decompressor::ArchiveDamagedError("Can't read lanes of block");
+    }
+    size_t lanes_count = static_cast<unsigned char>(data[0]);
+
+    std::vector<std::string> lanes;
+    size_t position = 1;
+    for (size_t lane = 0; lane < lanes_count; ++lane) {
+        if (data.size() - position < BlockHeader::SIZE) {
+            throw Decompressor::ArchiveDamagedError("Can't read lanes of block");
+        }
+        std::istringstream stream(data.substr(position, BlockHeader::SIZE));
+        BitReader bit_reader(stream);
+        BlockHeader lane_header = BlockHeader::Read(bit_reader);
+        position += BlockHeader::SIZE;
+        if (lane_header.codec == BlockCodec::LANES || lane_header.size > data.size() - position ||
+            lane_header.raw_size != (header.raw_size + lanes_count - 1 - lane) / lanes_count) {
+            throw Decompressor::ArchiveDamagedError("Lanes of block are damaged");
+        }
+        lanes.push_back(DecodeBlock(lane_header, data.substr(position, lane_header.size)));
+        position += lane_header.size;
+    }
+    if (position != data.size()) {
+        throw Decompressor::ArchiveDamagedError("Block size differs from its header");
+    }
+    return MergeLanes(lanes);
+}
+
+// Coders of codecs, which encoder tries only when they are enabled by options. Estimates keep models of data, so
+// that data isn't transformed twice
+
+class HuffmanCoder : public BlockCoder {
+public:
+    HuffmanCoder() : BlockCoder(BlockCodec::HUFFMAN, "huffman", 1){};
+
+    bool CompactTables() const override {
+        return true;
+    }
+
+    bool Enabled(const BlockEncoderOptions&) const override {
+        return true;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource& source, const BlockEncoderOptions&) const override {
+        return BlockEncoding{.bit_count = source.huffman_bit_count, .encode = [&source] {
+                                 return EncodeHuffman(source.data, BuildCode(BlockSymbolCounts(source.counts)));
+                             }};
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        return DecodeHuffman(header, data);
+    }
+};
+
+// Stored data isn't estimated: it is chosen, when no code gives enough gain
+class StoredCoder : public BlockCoder {
+public:
+    StoredCoder() : BlockCoder(BlockCodec::STORED, "stored", 0){};
+
+    bool Enabled(const BlockEncoderOptions&) const override {
+        return false;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource&, const BlockEncoderOptions&) const override {
+        return std::nullopt;
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        if (data.size() != header.raw_size) {
+            throw Decompressor::ArchiveDamagedError("Block size differs from its header");
+        }
+        return data;
+    }
+};
+
+class HuffmanOrder1Coder : public BlockCoder {
+public:
+    HuffmanOrder1Coder() : BlockCoder(BlockCodec::HUFFMAN_ORDER1, "order1", 1.2){};
+
+    bool CompactTables() const override {
+        return true;
+    }
+
+    bool Enabled(const BlockEncoderOptions& options) const override {
+        return options.order1;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource& source, const BlockEncoderOptions&) const override {
+        auto model = std::make_shared<Order1Model>(source.data, source.code_sizes);
+        return BlockEncoding{.bit_count = model->bit_count, .encode = [&source, model] {
+                                 model->BuildCodes();
+                                 return EncodeHuffmanOrder1(source.data, *model);
+                             }};
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        return DecodeHuffmanOrder1(header, data);
+    }
+};
+
+class Lz77Coder : public BlockCoder {
+public:
+    Lz77Coder() : BlockCoder(BlockCodec::LZ77, "lz77", 0.8){};
+
+    bool CompactTables() const override {
+        return true;
+    }
+
+    bool Enabled(const BlockEncoderOptions& options) const override {
+        return options.lz77;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource& source,
+                                          const BlockEncoderOptions& options) const override {
+        auto model = std::make_shared<Lz77Model>(source.data, options.lz77_options);
+        return BlockEncoding{.bit_count = model->bit_count, .encode = [model] { return EncodeLz77(*model); }};
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        return DecodeLz77(header, data);
+    }
+};
+
+class BwtCoder : public BlockCoder {
+public:
+    BwtCoder() : BlockCoder(BlockCodec::BWT, "bwt", 4){};
+
+    bool CompactTables() const override {
+        return true;
+    }
+
+    bool Enabled(const BlockEncoderOptions& options) const override {
+        return options.bwt;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource& source, const BlockEncoderOptions&) const override {
+        auto model = std::make_shared<BwtModel>(source.data);
+        return BlockEncoding{.bit_count = model->bit_count, .encode = [model] { return EncodeBwt(*model); }};
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        return DecodeBwt(header, data);
+    }
+};
+
+class TansCoder : public BlockCoder {
+public:
+    TansCoder() : BlockCoder(BlockCodec::TANS, "tans", 1){};
+
+    bool Enabled(const BlockEncoderOptions& options) const override {
+        return options.tans;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource& source, const BlockEncoderOptions&) const override {
+        TansCounts counts = NormalizeCounts(source.counts);
+        return BlockEncoding{.bit_count = counts.EstimateBitCount(source.counts),
+                             .encode = [&source, counts] { return EncodeTans(source.data, counts); }};
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        return DecodeTans(header, data);
+    }
+};
+
+class WordsCoder : public BlockCoder {
+public:
+    WordsCoder() : BlockCoder(BlockCodec::WORDS, "words", 0.7){};
+
+    bool Enabled(const BlockEncoderOptions& options) const override {
+        return options.words;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource& source, const BlockEncoderOptions&) const override {
+        if (source.data.size() < 2) {
+            return std::nullopt;
+        }
+        std::vector<size_t> counts = WordCounts(source.data);
+        auto table = std::make_shared<WordCodeTable>(BuildWordCodeTable(counts));
+        return BlockEncoding{.bit_count = table->EstimateBitCount(counts) + source.data.size() % 2 * 8,
+                             .encode = [&source, table] { return EncodeWords(source.data, *table); }};
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        return DecodeWords(header, data);
+    }
+};
+
+// Lanes aren't estimated like other codes: they are chosen with filters by entropy of lanes
+class LanesCoder : public BlockCoder {
+public:
+    LanesCoder() : BlockCoder(BlockCodec::LANES, "lanes", 1){};
+
+    bool Enabled(const BlockEncoderOptions&) const override {
+        return false;
+    }
+
+    std::optional<BlockEncoding> Estimate(const BlockSource&, const BlockEncoderOptions&) const override {
+        return std::nullopt;
+    }
+
+    std::string Decode(const BlockHeader& header, const std::string& data) const override {
+        return DecodeLanes(header, data);
+    }
+};
+
+static const HuffmanCoder HUFFMAN_CODER;
+static const StoredCoder STORED_CODER;
+static const HuffmanOrder1Coder HUFFMAN_ORDER1_CODER;
+static const Lz77Coder LZ77_CODER;
+static const BwtCoder BWT_CODER;
+static const TansCoder TANS_CODER;
+static const WordsCoder WORDS_CODER;
+static const LanesCoder LANES_CODER;
+
+// Coders in order of their codecs
+static const std::array<const BlockCoder*, BLOCK_CODECS_COUNT> BLOCK_CODERS = {
+    &HUFFMAN_CODER, &STORED_CODER, &HUFFMAN_ORDER1_CODER, &LZ77_CODER,
+    &BWT_CODER,     &TANS_CODER,   &WORDS_CODER,          &LANES_CODER};
+
+const BlockCoder& FindBlockCoder(BlockCodec codec) {
+    if (static_cast<size_t>(codec) >= BLOCK_CODERS.size()) {
+        throw Decompressor::ArchiveDamagedError("Unknown block codec");
+    }
+    return *BLOCK_CODERS[static_cast<size_t>(codec)];
+}
+
+// Header with size of encoded data and encoded data
+static std::string BlockWithHeader(BlockHeader header, const std::string& encoded) {
+    header.size = static_cast<uint32_t>(encoded.size());
+    StringBitWriter header_writer;
+    header.Write(header_writer);
+    header_writer.Complete();
+    return header_writer.Str() + encoded;
+}
+
+// Compress data after filter into block with header. Every enabled coder estimates size of data, and the coder with
+// the least size, that is increased by its decoding cost if speed is weighted, is used. Data is stored as is without
+// filter, if no code gives enough gain
+static std::string EncodeFilteredBlock(const std::string& data, BlockFilter filter,
+                                       const BlockEncoderOptions& options) {
+    BlockHeader header;
+    header.raw_size = static_cast<uint32_t>(data.size());
+    std::string encoded;
+    std::string filtered = filter == BlockFilter::NONE ? std::string() : ApplyFilter(data, filter);
+    BlockSource source{.data = filter == BlockFilter::NONE ? data : filtered};
+
+    header.codec = BlockCodec::STORED;
+    if (!source.data.empty()) {
+        for (char c : source.data) {
+            ++source.counts[static_cast<unsigned char>(c)];
+        }
+        source.huffman_bit_count = EstimateBitCount(BlockSymbolCounts(source.counts), source.code_sizes);
+
+        const BlockCoder* best_coder = nullptr;
+        std::optional<BlockEncoding> best;
+        double best_score = 0;
+        for (const BlockCoder* coder : BLOCK_CODERS) {
+            if (!coder->Enabled(options)) {
+                continue;
+            }
+            std::optional<BlockEncoding> encoding = coder->Estimate(source, options);
+            if (!encoding) {
+                continue;
+            }
+            double score = static_cast<double>(encoding->bit_count) *
+                           (1 + static_cast<double>(options.speed_weight) / 100 * coder->DecodeCost());
+            if (best_coder == nullptr || score < best_score) {
+                best_coder = coder;
+                best = std::move(encoding);
+                best_score = score;
+            }
+        }
+
+        size_t size = (best->bit_count + 7) / 8;
+        if (size * 100 < data.size() * (100 - STORED_MIN_GAIN_PERCENT)) {
+            header.codec = best_coder->Codec();
+            header.filter = filter;
+            header.compact_tables = best_coder->CompactTables();
+            encoded = best->encode();
+        }
+    }
+    if (header.codec == BlockCodec::STORED) {
+        encoded = data;
+    }
+    return BlockWithHeader(header, encoded);
+}
+
+// Histogram of every step-th byte of data starting from start, filter subtracts byte stride steps before from it
+static Histogram FilteredCounts(const std::string& data, size_t stride, size_t start, size_t step) {
+    Histogram counts = {};
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    size_t distance = stride * step;
+    for (size_t i = start; i < data.size(); i += step) {
+        unsigned char previous = distance > 0 && i >= start + distance ? bytes[i - distance] : 0;
+        ++counts[static_cast<unsigned char>(bytes[i] - previous)];
+    }
+    return counts;
+}
+
+struct FilterChoice {
+    BlockFilter filter = BlockFilter::NONE;
+    double bit_count = 0;
+};
+
+// Filter of every step-th byte of data starting from start, that gives the least estimated size
+static FilterChoice ChooseFilter(const std::string& data, size_t start = 0, size_t step = 1) {
+    FilterChoice best;
+    for (size_t filter = 0; filter < BLOCK_FILTERS_COUNT; ++filter) {
+        size_t stride = FilterStride(static_cast<BlockFilter>(filter));
+        double bit_count = EstimateEntropyBitCount(FilteredCounts(data, stride, start, step));
+        if (filter == 0 || bit_count < best.bit_count) {
+            best = {.filter = static_cast<BlockFilter>(filter), .bit_count = bit_count};
+        }
+    }
+    return best;
+}
+
+// Sizes of records, which bytes may be coded by lanes
+static constexpr std::array<size_t, 3> LANES_COUNTS = {2, 4, 8};
+
+// Count of lanes, then every lane as inner block with its own filter and code. Data is stored as is, if lanes don't
+// give enough gain
+static std::string EncodeLanes(const std::string& data, size_t lanes_count, const BlockEncoderOptions& options) {
+    std::string encoded(1, static_cast<char>(lanes_count));
+    for (const auto& lane : SplitLanes(data, lanes_count)) {
+        encoded += EncodeFilteredBlock(lane, ChooseFilter(lane).filter, options);
+    }
+
+    BlockHeader header;
+    header.raw_size = static_cast<uint32_t>(data.size());
+    header.codec = BlockCodec::LANES;
+    if (encoded.size() * 100 >= data.size() * (100 - STORED_MIN_GAIN_PERCENT)) {
+        header.codec = BlockCodec::STORED;
+        encoded = data;
+    }
+    return BlockWithHeader(header, encoded);
+}
+
+// Compress data into block with header. If filters are enabled, delta filter or byte lanes with the least entropy
+// are chosen before the code
+std::string EncodeBlock(const std::string& data, const BlockEncoderOptions& options) {
+    if (!options.filters || data.empty()) {
+        return EncodeFilteredBlock(data, BlockFilter::NONE, options);
+    }
+
+    FilterChoice choice = ChooseFilter(data);
+    size_t best_lanes_count = 1;
+    double best_bit_count = choice.bit_count;
+    for (size_t lanes_count : LANES_COUNTS) {
+        double bit_count = BlockHeader::SIZE * 8 + 8;
+        for (size_t lane = 0; lane < lanes_count; ++lane) {
+            bit_count += ChooseFilter(data, lane, lanes_count).bit_count;
+        }
+        if (bit_count < best_bit_count) {
+            best_bit_count = bit_count;
+            best_lanes_count = lanes_count;
+        }
+    }
+    if (best_lanes_count > 1) {
+        return EncodeLanes(data, best_lanes_count, options);
+    }
+    return EncodeFilteredBlock(data, choice.filter, options);
+}
+
+// Parts of data start at multiples of segment size, segments of large data are larger to bound count of segments
+static constexpr size_t SPLIT_MIN_SEGMENT_SIZE = 1 << 14;
+static constexpr size_t SPLIT_MAX_SEGMENTS_COUNT = 128;
+
+// Sizes of parts of data, that are better coded by separate blocks. Every part is estimated by entropy of its
+// histogram and cost of its table, and parts are chosen by dynamic programming over segment boundaries to minimize
+// total estimate
+std::vector<size_t> SplitBlock(const std::string& data) {
+    size_t segment_size = std::max(SPLIT_MIN_SEGMENT_SIZE,
+                                   (data.size() + SPLIT_MAX_SEGMENTS_COUNT - 1) / SPLIT_MAX_SEGMENTS_COUNT);
+    size_t segments_count = (data.size() + segment_size - 1) / segment_size;
+    if (segments_count <= 1) {
+        return {data.size()};
+    }
+
+    // Histograms of data prefixes ending at segment boundaries
+    std::vector<Histogram> prefix_counts(segments_count + 1);
+    prefix_counts[0] = {};
+    for (size_t segment = 0; segment < segments_count; ++segment) {
+        prefix_counts[segment + 1] = prefix_counts[segment];
+        size_t end = std::min(data.size(), (segment + 1) * segment_size);
+        for (size_t i = segment * segment_size; i < end; ++i) {
+            ++prefix_counts[segment + 1][static_cast<unsigned char>(data[i])];
+        }
+    }
+
+    // The best estimate of the first segments and start of the last part in it
+    std::vector<double> best(segments_count + 1, 0);
+    std::vector<size_t> part_start(segments_count + 1, 0);
+    Histogram counts;
+    for (size_t end = 1; end <= segments_count; ++end) {
+        for (size_t start = 0; start < end; ++start) {
+            for (size_t c = 0; c < counts.size(); ++c) {
+                counts[c] = prefix_counts[end][c] - prefix_counts[start][c];
+            }
+            double estimate = best[start] + EstimateEntropyBitCount(counts);
+            if (start == 0 || estimate < best[end]) {
+                best[end] = estimate;
+                part_start[end] = start;
+            }
+        }
+    }
+
+    std::vector<size_t> sizes;
+    for (size_t end = segments_count; end > 0; end = part_start[end]) {
+        sizes.push_back(std::min(data.size(), end * segment_size) - part_start[end] * segment_size);
+    }
+    std::reverse(sizes.begin(), sizes.end());
+    return sizes;
+}
+
+// Compress data into one block or, if splitting is enabled, into blocks of its parts one after another
+std::string EncodeBlocks(const std::string& data, const BlockEncoderOptions& options) {
+    if (!options.split) {
+        return EncodeBlock(data, options);
+    }
+    std::string blocks;
+    size_t offset = 0;
+    for (size_t size : SplitBlock(data)) {
+        blocks += EncodeBlock(data.substr(offset, size), options);
+        offset += size;
+    }
+    return blocks;
+}
+
+// Decompress data of block
+std::string DecodeBlock(const BlockHeader& header, const std::string& data) {
+    std::string result = FindBlockCoder(header.codec).Decode(header, data);
+    RevertFilter(result, header.filter);
+    return result;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "filter.h"
+#include "lz77.h"
+#include "service_symbols.h"
+#include "utils/bit_reader.h"
+#include "utils/bit_writer.h"
+
+// Compression methods of indexed archive blocks
+enum class BlockCodec : uint8_t {
+    HUFFMAN = 0,         // Canonical Huffman code with own table, data ends with BLOCK_END symbol
+    STORED = 1,          // Original data as is
+    HUFFMAN_ORDER1 = 2,  // Canonical Huffman codes chosen by previous byte, rare contexts share one code
+    LZ77 = 3,            // Literals and matches with previous data, coded by two canonical Huffman codes
+    BWT = 4,             // Burrows-Wheeler transform, move-to-front and zero runs, coded by canonical Huffman code
+    TANS = 5,            // Table-based asymmetric numeral system code with normalized counts of bytes
+    WORDS = 6,           // Canonical Huffman code of 16-bit little-endian words with sparse table
+    LANES = 7,           // Byte lanes of records, every lane is coded as separate inner block
+};
+static constexpr size_t BLOCK_CODECS_COUNT = 8;
+
+// Codecs, that encoder may try for blocks besides order-0 Huffman code and stored data
+struct BlockEncoderOptions {
+    static constexpr size_t MAX_SPEED_WEIGHT = 1000;
+
+    bool order1 = false;
+    bool lz77 = false;
+    Lz77Options lz77_options;
+    bool bwt = false;
+    bool tans = false;
+    bool words = false;
+    bool filters = false;     // Choose delta filter or byte lanes for every block by entropy of their bytes
+    size_t speed_weight = 0;  // Percent of size, that codec may lose for every unit of its decoding cost
+    bool split = false;       // Split data into several blocks, where its statistics change
+};
+
+// Blocks, which Huffman code saves less than this part of their size, are stored
+static constexpr size_t STORED_MIN_GAIN_PERCENT = 2;
+
+// Header, that precedes data of every block in indexed archive
+struct BlockHeader {
+    static constexpr size_t SIZE = 9;                  // Size of header in bytes
+    static constexpr uint8_t COMPACT_TABLES = 1 << 7;  // Flag of codec byte: code tables are written in compact form
+    static constexpr uint8_t CODEC_MASK = 0x0F;        // Codec is in the lowest bits of codec byte
+    static constexpr size_t FILTER_SHIFT = 4;          // Filter is in the next three bits
+
+    BlockCodec codec = BlockCodec::HUFFMAN;
+    BlockFilter filter = BlockFilter::NONE;  // Filter of data, that is reverted after decoding
+    bool compact_tables = false;
+    uint32_t raw_size = 0;  // Size of original data
+    uint32_t size = 0;      // Size of encoded data after header
+
+    void Write(BitWriter& bit_writer) const;
+    static BlockHeader Read(BitReader& bit_reader);
+};
+
+using Histogram = std::array<size_t, 1 << FILE_FIXED_CHAR_SIZE>;
+
+// Data of block, that every coder estimates: bytes, their counts and order-0 Huffman code sizes of bytes and BLOCK_END
+struct BlockSource {
+    const std::string& data;
+    Histogram counts = {};
+    std::vector<size_t> code_sizes;
+    size_t huffman_bit_count = 0;  // Size of data coded by order-0 Huffman code with its table
+};
+
+// Estimated size of block data coded by some coder. Model of data is kept to encode it, if the coder is chosen, so
+// encode may be called while source of estimate exists
+struct BlockEncoding {
+    size_t bit_count = 0;
+    std::function<std::string()> encode;
+};
+
+// Method of coding of block data. Coders are registered at compile time by their codecs: encoder estimates every
+// enabled coder and chooses one by size and decoding cost, decoder finds coder by codec of block header
+class BlockCoder {
+public:
+    BlockCoder(BlockCodec codec, std::string_view name, double decode_cost)
+        : codec_(codec), name_(name), decode_cost_(decode_cost){};
+    virtual ~BlockCoder() = default;
+
+    BlockCodec Codec() const {
+        return codec_;
+    }
+    std::string_view Name() const {
+        return name_;
+    }
+
+    // Time of decoding of a byte relative to order-0 Huffman code
+    double DecodeCost() const {
+        return decode_cost_;
+    }
+
+    // Whether code tables of blocks are written in compact form
+    virtual bool CompactTables() const {
+        return false;
+    }
+
+    virtual bool Enabled(const BlockEncoderOptions& options) const = 0;
+
+    // Nothing, if the coder can't code data
+    virtual std::optional<BlockEncoding> Estimate(const BlockSource& source,
+                                                  const BlockEncoderOptions& options) const = 0;
+    virtual std::string Decode(const BlockHeader& header, const std::string& data) const = 0;
+
+private:
+    BlockCodec codec_;
+    std::string_view name_;
+    double decode_cost_;
+};
+
+const BlockCoder& FindBlockCoder(BlockCodec codec);
+
+std::string EncodeBlock(const std::string& data, const BlockEncoderOptions& options = BlockEncoderOptions());
+std::string DecodeBlock(const BlockHeader& header, const std::string& data);
+
+std::vector<size_t> SplitBlock(const std::string& data);
+std::string EncodeBlocks(const std::string& data, const BlockEncoderOptions& options = BlockEncoderOptions());
@@ -0,0 +1,270 @@
+#include "bwt.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#include "decompressor.h"
+
+// Suffix array of s with values from 0 to upper by SA-IS algorithm in linear time: LMS suffixes are sorted by
+// recursion on their names, then all other suffixes are induced from them
+std::vector<int> SuffixArray(const std::vector<int>& s, int upper) {
+    int n = static_cast<int>(s.size());
+    if (n == 0) {
+        return {};
+    }
+    if (n == 1) {
+        return {0};
+    }
+    if (n == 2) {
+        return s[0] < s[1] ? std::vector<int>{0, 1} : std::vector<int>{1, 0};
+    }
+
+    // Type of every suffix: S-type is less than the next suffix, L-type is greater
+    std::vector<int> sa(n);
+    std::vector<bool> is_s(n);
+    for (int i = n - 2; i >= 0; --i) {
+        is_s[i] = s[i] == s[i + 1] ? is_s[i + 1] : s[i] < s[i + 1];
+    }
+
+    // Starts of L-type and S-type parts of every bucket
+    std::vector<int> sum_l(upper + 1);
+    std::vector<int> sum_s(upper + 1);
+    for (int i = 0; i < n; ++i) {
+        if (!is_s[i]) {
+            ++sum_s[s[i]];
+        } else {
+            ++sum_l[s[i] + 1];
+        }
+    }
+    for (int i = 0; i <= upper; ++i) {
+        sum_s[i] += sum_l[i];
+        if (i < upper) {
+            sum_l[i + 1] += sum_s[i];
+        }
+    }
+
+    auto induce = [&](const std::vector<int>& lms) {
+        std::fill(sa.begin(), sa.end(), -1);
+        std::vector<int> buffer(upper + 1);
+        std::copy(sum_s.begin(), sum_s.end(), buffer.begin());
+        for (int d : lms) {
+            if (d != n) {
+                sa[buffer[s[d]]++] = d;
+            }
+        }
+        std::copy(sum_l.begin(), sum_l.end(), buffer.begin());
+        sa[buffer[s[n - 1]]++] = n - 1;
+        for (int i = 0; i < n; ++i) {
+            int v = sa[i];
+            if (v >= 1 && !is_s[v - 1]) {
+                sa[buffer[s[v - 1]]++] = v - 1;
+            }
+        }
+        std::copy(sum_l.begin(), sum_l.end(), buffer.begin());
+        for (int i = n - 1; i >= 0; --i) {
+            int v = sa[i];
+            if (v >= 1 && is_s[v - 1]) {
+                sa[--buffer[s[v - 1] + 1]] = v - 1;
+            }
+        }
+    };
+
+    // LMS suffixes are S-type suffixes after L-type ones
+    std::vector<int> lms_map(n + 1, -1);
+    std::vector<int> lms;
+    for (int i = 1; i < n; ++i) {
+        if (!is_s[i - 1] && is_s[i]) {
+            lms_map[i] = static_cast<int>(lms.size());
+            lms.push_back(i);
+        }
+    }
+    int m = static_cast<int>(lms.size());
+
+    induce(lms);
+
+    if (m > 0) {
+        std::vector<int> sorted_lms;
+        sorted_lms.reserve(m);
+        for (int v : sa) {
+            if (lms_map[v] != -1) {
+                sorted_lms.push_back(v);
+            }
+        }
+
+        // Name LMS substrings, equal substrings get equal names
+        std::vector<int> names(m);
+        int upper_name = 0;
+        names[lms_map[sorted_lms[0]]] = 0;
+        for (int i = 1; i < m; ++i) {
+            int l = sorted_lms[i - 1];
+            int r = sorted_lms[i];
+            int end_l = lms_map[l] + 1 < m ? lms[lms_map[l] + 1] : n;
+            int end_r = lms_map[r] + 1 < m ? lms[lms_map[r] + 1] : n;
+            bool same = true;
+            if (end_l - l != end_r - r) {
+                same = false;
+            } else {
+                while (l < end_l && s[l] == s[r]) {
+                    ++l;
+                    ++r;
+                }
+                if (l == n || s[l] != s[r]) {
+                    same = false;
+                }
+            }
+            if (!same) {
+                ++upper_name;
+            }
+            names[lms_map[sorted_lms[i]]] = upper_name;
+        }
+
+        std::vector<int> names_sa = SuffixArray(names, upper_name);
+        for (int i = 0; i < m; ++i) {
+            sorted_lms[i] = lms[names_sa[i]];
+        }
+        induce(sorted_lms);
+    }
+    return sa;
+}
+
+// Burrows-Wheeler transform: the last column of sorted rotations of data with end marker, that is less than all
+// bytes. The marker itself isn't written, primary_index is its row
+std::string BwtForward(const std::string& data, uint32_t& primary_index) {
+    std::vector<int> s(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        s[i] = static_cast<unsigned char>(data[i]);
+    }
+    std::vector<int> sa = SuffixArray(s, 255);
+
+    // The first row starts with the marker and ends with the last byte
+    std::string last_column;
+    last_column.reserve(data.size());
+    if (!data.empty()) {
+        last_column += data.back();
+    }
+    primary_index = 0;
+    for (size_t i = 0; i < sa.size(); ++i) {
+        if (sa[i] == 0) {
+            primary_index = static_cast<uint32_t>(i + 1);
+        } else {
+            last_column += data[sa[i] - 1];
+        }
+    }
+    return last_column;
+}
+
+// Restore data from the last column by walking rows from the end of data to its start
+std::string BwtInverse(const std::string& last_column, uint32_t primary_index) {
+    size_t n = last_column.size();
+    if (primary_index > n || (n > 0 && primary_index == 0)) {
+        throw Decompressor::ArchiveDamagedError("Wrong primary index of block");
+    }
+
+    // Row of every byte in the first column, the first row is taken by the marker
+    std::array<size_t, 256> first_row = {};
+    for (char c : last_column) {
+        ++first_row[static_cast<unsigned char>(c)];
+    }
+    size_t sum = 1;
+    for (size_t& row : first_row) {
+        std::swap(row, sum);
+        sum += row;
+    }
+
+    std::vector<uint32_t> next_row(n + 1);
+    for (size_t row = 0; row <= n; ++row) {
+        if (row != primary_index) {
+            unsigned char c = last_column[row - (row > primary_index)];
+            next_row[row] = static_cast<uint32_t>(first_row[c]++);
+        }
+    }
+
+    std::string data(n, '\0');
+    size_t row = 0;
+    for (size_t i = n; i-- > 0;) {
+        data[i] = last_column[row - (row > primary_index)];
+        row = next_row[row];
+    }
+    return data;
+}
+
+// Write zero run as bijective base-2 number
+void WriteRun(size_t run, std::vector<uint16_t>& symbols) {
+    while (run > 0) {
+        if (run & 1) {
+            symbols.push_back(BWT_RUN_A);
+            run = (run - 1) / 2;
+        } else {
+            symbols.push_back(BWT_RUN_B);
+            run = (run - 2) / 2;
+        }
+    }
+}
+
+// Move-to-front transform with zero runs coding, data after BWT gives mostly zeros and small indices
+std::vector<uint16_t> MoveToFrontRle(const std::string& data) {
+    std::array<unsigned char, 256> order;
+    std::iota(order.begin(), order.end(), 0);
+
+    std::vector<uint16_t> symbols;
+    symbols.reserve(data.size());
+    size_t run = 0;
+    for (char c : data) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        size_t index = std::find(order.begin(), order.end(), byte) - order.begin();
+        if (index == 0) {
+            ++run;
+            continue;
+        }
+        WriteRun(run, symbols);
+        run = 0;
+        std::move_backward(order.begin(), order.begin() + index, order.begin() + index + 1);
+        order[0] = byte;
+        symbols.push_back(static_cast<uint16_t>(index + 1));
+    }
+    WriteRun(run, symbols);
+    return symbols;
+}
+
+std::string MoveToFrontRleInverse(const std::vector<uint16_t>& symbols, size_t size) {
+    std::array<unsigned char, 256> order;
+    std::iota(order.begin(), order.end(), 0);
+
+    std::string data;
+    data.reserve(size);
+    size_t run = 0;
+    size_t run_weight = 1;
+    for (size_t i = 0; i <= symbols.size(); ++i) {
+        if (i < symbols.size() && (symbols[i] == BWT_RUN_A || symbols[i] == BWT_RUN_B)) {
+            run += (symbols[i] == BWT_RUN_A ? 1 : 2) * run_weight;
+            run_weight <<= 1;
+            if (run > size) {
+                throw Decompressor::ArchiveDamagedError("Block size differs from its header");
+            }
+            continue;
+        }
+        if (run > size - data.size()) {
+            throw Decompressor::ArchiveDamagedError("Block size differs from its header");
+        }
+        data.append(run, static_cast<char>(order[0]));
+        run = 0;
+        run_weight = 1;
+        if (i == symbols.size()) {
+            break;
+        }
+
+        size_t index = symbols[i] - 1;
+        if (index >= order.size() || data.size() == size) {
+            throw Decompressor::ArchiveDamagedError("Can't decode block char code");
+        }
+        unsigned char byte = order[index];
+        std::move_backward(order.begin(), order.begin() + index, order.begin() + index + 1);
+        order[0] = byte;
+        data += static_cast<char>(byte);
+    }
+    if (data.size() != size) {
+        throw Decompressor::ArchiveDamagedError("Block size differs from its header");
+    }
+    return data;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Zero runs after move-to-front are written by bijective base-2 digits RUN_A (1) and RUN_B (2), other indices are
+// shifted by one, so symbols are 0..256
+static constexpr uint16_t BWT_RUN_A = 0;
+static constexpr uint16_t BWT_RUN_B = 1;
+static constexpr size_t BWT_SYMBOLS_COUNT = 257;
+
+std::vector<int> SuffixArray(const std::vector<int>& s, int upper);
+
+std::string BwtForward(const std::string& data, uint32_t& primary_index);
+std::string BwtInverse(const std::string& last_column, uint32_t primary_index);
+
+std::vector<uint16_t> MoveToFrontRle(const std::string& data);
+std::string MoveToFrontRleInverse(const std::vector<uint16_t>& symbols, size_t size);
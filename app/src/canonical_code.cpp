@@ -0,0 +1,480 @@
+#include "canonical_code.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "decompressor.h"
+
+// Write table, that is enough to recover canonical code
+void WriteCodeTable(BitWriter& bit_writer, const CanonicalCodeGenerator<CharT>& canonical_code) {
+    bit_writer.Write(canonical_code.Size(), ARCHIVE_FIXED_CHAR_SIZE);
+    for (const auto& character : canonical_code.Order()) {
+        bit_writer.Write(character, ARCHIVE_FIXED_CHAR_SIZE);
+    }
+    for (const auto& size_count : canonical_code.CodeSizesCount()) {
+        bit_writer.Write(size_count, ARCHIVE_FIXED_CHAR_SIZE);
+    }
+}
+
+// Size of table in archive in bits
+size_t CodeTable::BitCount() const {
+    return bit_count;
+}
+
+// Read table, that is enough to recover canonical code
+CodeTable ReadCodeTable(BitReader& bit_reader) {
+    CodeTable code_table;
+    size_t symbols_count = 0;
+
+    // Read symbols count
+    bit_reader.Get(symbols_count, ARCHIVE_FIXED_CHAR_SIZE);
+
+    // Read symbols order
+    code_table.order.resize(symbols_count);
+    for (size_t i = 0; i < symbols_count; ++i) {
+        CharT symbol = 0;
+        if (!bit_reader.Get(symbol, ARCHIVE_FIXED_CHAR_SIZE)) {
+            throw Decompressor::ArchiveDamagedError("Can't read symbols order");
+        }
+        code_table.order[i] = symbol;
+    }
+
+    // Read code sizes count
+    size_t sum_size_count = 0;
+    while (sum_size_count < symbols_count) {
+        size_t size_count = 0;
+        if (!bit_reader.Get(size_count, ARCHIVE_FIXED_CHAR_SIZE)) {
+            break;
+        }
+        sum_size_count += size_count;
+        code_table.code_sizes_count.push_back(size_count);
+    }
+    if (sum_size_count != symbols_count) {
+        throw Decompressor::ArchiveDamagedError("Can't read code sizes count");
+    }
+
+    code_table.bit_count = ARCHIVE_FIXED_CHAR_SIZE * (1 + symbols_count + code_table.code_sizes_count.size());
+    return code_table;
+}
+
+// Symbols of code of code sizes: sizes up to 15, repeat of the previous size 3..6 times, 3..10 and 11..138 zeros and
+// size above 15 written by extra bits
+static constexpr size_t SIZE_SYMBOLS_COUNT = 20;
+static constexpr size_t MAX_SHORT_SIZE = 15;
+static constexpr size_t REPEAT_PREVIOUS = 16;
+static constexpr size_t REPEAT_ZEROS = 17;
+static constexpr size_t REPEAT_ZEROS_LONG = 18;
+static constexpr size_t LONG_SIZE = 19;
+static constexpr std::array<size_t, SIZE_SYMBOLS_COUNT> EXTRA_BIT_COUNTS = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                                            0, 0, 0, 0, 0, 0, 2, 3, 7, 6};
+static constexpr std::array<size_t, SIZE_SYMBOLS_COUNT> EXTRA_BASES = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                                       0, 0, 0, 0, 0, 0, 3, 3, 11, 0};
+
+// Sizes of code of code sizes are written by 3 bits in this order, so that rarely used symbols may be left out. At
+// least 5 of them are written, so that their count fits 4 bits
+static constexpr std::array<size_t, SIZE_SYMBOLS_COUNT> SIZE_SYMBOLS_ORDER = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                                                              11, 4,  12, 3, 13, 2, 14, 1, 15, 19};
+static constexpr size_t SIZE_CODE_SIZE_BITS = 3;
+static constexpr size_t MAX_SIZE_CODE_SIZE = (1 << SIZE_CODE_SIZE_BITS) - 1;
+static constexpr size_t MIN_SIZE_SYMBOLS_WRITTEN = 5;
+
+// The longest run, that symbol of repeat can write
+static size_t MaxRun(size_t symbol) {
+    return EXTRA_BASES[symbol] + (static_cast<size_t>(1) << EXTRA_BIT_COUNTS[symbol]) - 1;
+}
+
+struct SizeToken {
+    size_t symbol;
+    size_t extra;
+};
+
+// Split code sizes into runs of zeros, repeats and single sizes
+static std::vector<SizeToken> SizeTokens(const std::vector<size_t>& code_sizes, size_t count) {
+    std::vector<SizeToken> tokens;
+    for (size_t i = 0; i < count;) {
+        size_t size = code_sizes[i];
+        size_t run = 1;
+        while (i + run < count && code_sizes[i + run] == size) {
+            ++run;
+        }
+
+        if (size == 0 && run >= EXTRA_BASES[REPEAT_ZEROS]) {
+            run = std::min(run, MaxRun(REPEAT_ZEROS_LONG));
+            if (run >= EXTRA_BASES[REPEAT_ZEROS_LONG]) {
+                tokens.push_back({.symbol = REPEAT_ZEROS_LONG, .extra = run - EXTRA_BASES[REPEAT_ZEROS_LONG]});
+            } else {
+                tokens.push_back({.symbol = REPEAT_ZEROS, .extra = run - EXTRA_BASES[REPEAT_ZEROS]});
+            }
+            i += run;
+            continue;
+        }
+
+        tokens.push_back(size > MAX_SHORT_SIZE ? SizeToken{.symbol = LONG_SIZE, .extra = size}
+                                               : SizeToken{.symbol = size, .extra = 0});
+        ++i;
+        --run;
+        if (size == 0) {
+            continue;
+        }
+        while (run >= EXTRA_BASES[REPEAT_PREVIOUS]) {
+            size_t repeat = std::min(run, MaxRun(REPEAT_PREVIOUS));
+            tokens.push_back({.symbol = REPEAT_PREVIOUS, .extra = repeat - EXTRA_BASES[REPEAT_PREVIOUS]});
+            i += repeat;
+            run -= repeat;
+        }
+    }
+    return tokens;
+}
+
+// Huffman code sizes, that don't exceed max_size: counts are halved until the code is short enough
+static std::vector<size_t> LimitedCodeSizes(std::vector<size_t> counts, size_t max_size) {
+    while (true) {
+        std::vector<size_t> sizes = HuffmanCodeSizes(counts);
+        if (*std::max_element(sizes.begin(), sizes.end()) <= max_size) {
+            return sizes;
+        }
+        for (size_t& count : counts) {
+            count = (count + 1) / 2;
+        }
+    }
+}
+
+// Canonical codes of symbols with given sizes, symbols with the same size get codes in order of symbols
+static std::vector<uint64_t> CanonicalCodes(const std::vector<size_t>& sizes) {
+    std::vector<size_t> symbols;
+    for (size_t symbol = 0; symbol < sizes.size(); ++symbol) {
+        if (sizes[symbol] > 0) {
+            symbols.push_back(symbol);
+        }
+    }
+    std::stable_sort(symbols.begin(), symbols.end(), [&sizes](size_t a, size_t b) { return sizes[a] < sizes[b]; });
+
+    std::vector<uint64_t> codes(sizes.size(), 0);
+    uint64_t code = 0;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (i > 0) {
+            code = (code + 1) << (sizes[symbols[i]] - sizes[symbols[i - 1]]);
+        }
+        codes[symbols[i]] = code;
+    }
+    return codes;
+}
+
+// Code sizes of symbols of canonical code, the greatest symbol is the last one
+static std::vector<size_t> CodeSizes(const CanonicalCodeGenerator<CharT>& canonical_code) {
+    std::vector<size_t> code_sizes;
+    for (CharT symbol : canonical_code.Order()) {
+        code_sizes.resize(std::max<size_t>(code_sizes.size(), symbol + 1), 0);
+        code_sizes[symbol] = canonical_code[symbol].Size();
+    }
+    return code_sizes;
+}
+
+// Write or only measure code sizes without their count: sizes of code of code sizes, then code sizes by this code
+size_t WriteCodeSizes(BitWriter* bit_writer, const std::vector<size_t>& code_sizes) {
+    std::vector<SizeToken> tokens = SizeTokens(code_sizes, code_sizes.size());
+
+    std::vector<size_t> counts(SIZE_SYMBOLS_COUNT, 0);
+    for (const auto& token : tokens) {
+        ++counts[token.symbol];
+    }
+    std::vector<size_t> sizes = LimitedCodeSizes(counts, MAX_SIZE_CODE_SIZE);
+    std::vector<uint64_t> codes = CanonicalCodes(sizes);
+
+    size_t written_count = SIZE_SYMBOLS_COUNT;
+    while (written_count > MIN_SIZE_SYMBOLS_WRITTEN && sizes[SIZE_SYMBOLS_ORDER[written_count - 1]] == 0) {
+        --written_count;
+    }
+
+    size_t bit_count = 4 + SIZE_CODE_SIZE_BITS * written_count;
+    for (const auto& token : tokens) {
+        bit_count += sizes[token.symbol] + EXTRA_BIT_COUNTS[token.symbol];
+    }
+    if (bit_writer == nullptr) {
+        return bit_count;
+    }
+
+    bit_writer->Write(written_count - MIN_SIZE_SYMBOLS_WRITTEN, 4);
+    for (size_t i = 0; i < written_count; ++i) {
+        bit_writer->Write(sizes[SIZE_SYMBOLS_ORDER[i]], SIZE_CODE_SIZE_BITS);
+    }
+    for (const auto& token : tokens) {
+        bit_writer->Write(codes[token.symbol], sizes[token.symbol]);
+        bit_writer->Write(token.extra, EXTRA_BIT_COUNTS[token.symbol]);
+    }
+    return bit_count;
+}
+
+// Write or only measure compact table of code sizes, sizes after the last used symbol are left out
+static size_t WriteCompactSizes(BitWriter* bit_writer, std::vector<size_t> code_sizes) {
+    while (!code_sizes.empty() && code_sizes.back() == 0) {
+        code_sizes.pop_back();
+    }
+    if (bit_writer != nullptr) {
+        bit_writer->Write(false);
+        bit_writer->Write(code_sizes.size(), ARCHIVE_FIXED_CHAR_SIZE);
+    }
+    return 1 + ARCHIVE_FIXED_CHAR_SIZE + WriteCodeSizes(bit_writer, code_sizes);
+}
+
+void WriteCompactCodeTable(BitWriter& bit_writer, const CanonicalCodeGenerator<CharT>& canonical_code,
+                           const CanonicalCodeGenerator<CharT>* previous) {
+    std::vector<size_t> code_sizes = CodeSizes(canonical_code);
+    if (previous != nullptr && CodeSizes(*previous) == code_sizes) {
+        bit_writer.Write(true);
+        return;
+    }
+    WriteCompactSizes(&bit_writer, code_sizes);
+}
+
+// Size of compact table of code with given code sizes in bits
+size_t CompactCodeTableBitCount(const std::vector<size_t>& code_sizes) {
+    return WriteCompactSizes(nullptr, code_sizes);
+}
+
+// Decode symbol of canonical code with given sizes bit by bit
+static size_t ReadCanonicalSymbol(BitReader& bit_reader, const std::vector<size_t>& sizes,
+                                  const std::vector<uint64_t>& codes) {
+    uint64_t code = 0;
+    for (size_t size = 1; size <= MAX_SIZE_CODE_SIZE; ++size) {
+        bool bit = false;
+        if (!bit_reader.Get(bit)) {
+            break;
+        }
+        code = code << 1 | bit;
+        for (size_t symbol = 0; symbol < sizes.size(); ++symbol) {
+            if (sizes[symbol] == size && codes[symbol] == code) {
+                return symbol;
+            }
+        }
+    }
+    throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+}
+
+std::vector<size_t> ReadCodeSizes(BitReader& bit_reader, size_t count, size_t& bit_count) {
+    size_t written_count = 0;
+    if (!bit_reader.Get(written_count, 4)) {
+        throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+    }
+    written_count += MIN_SIZE_SYMBOLS_WRITTEN;
+    if (written_count > SIZE_SYMBOLS_COUNT) {
+        throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+    }
+    bit_count += 4 + SIZE_CODE_SIZE_BITS * written_count;
+
+    std::vector<size_t> sizes(SIZE_SYMBOLS_COUNT, 0);
+    for (size_t i = 0; i < written_count; ++i) {
+        if (!bit_reader.Get(sizes[SIZE_SYMBOLS_ORDER[i]], SIZE_CODE_SIZE_BITS)) {
+            throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+        }
+    }
+    std::vector<uint64_t> codes = CanonicalCodes(sizes);
+
+    std::vector<size_t> code_sizes;
+    while (code_sizes.size() < count) {
+        size_t symbol = ReadCanonicalSymbol(bit_reader, sizes, codes);
+        size_t extra = 0;
+        if (EXTRA_BIT_COUNTS[symbol] > 0 && !bit_reader.Get(extra, EXTRA_BIT_COUNTS[symbol])) {
+            throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+        }
+        bit_count += sizes[symbol] + EXTRA_BIT_COUNTS[symbol];
+
+        if (symbol <= MAX_SHORT_SIZE) {
+            code_sizes.push_back(symbol);
+        } else if (symbol == LONG_SIZE) {
+            code_sizes.push_back(extra);
+        } else {
+            size_t run = EXTRA_BASES[symbol] + extra;
+            if (symbol == REPEAT_PREVIOUS && code_sizes.empty()) {
+                throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+            }
+            code_sizes.resize(code_sizes.size() + run, symbol == REPEAT_PREVIOUS ? code_sizes.back() : 0);
+        }
+    }
+    if (code_sizes.size() != count) {
+        throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+    }
+    return code_sizes;
+}
+
+CodeTable ReadCompactCodeTable(BitReader& bit_reader, const CodeTable* previous) {
+    bool reuse = false;
+    if (!bit_reader.Get(reuse)) {
+        throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+    }
+    if (reuse) {
+        if (previous == nullptr) {
+            throw Decompressor::ArchiveDamagedError("Code table refers to missing previous table");
+        }
+        CodeTable code_table = *previous;
+        code_table.bit_count = 1;
+        return code_table;
+    }
+
+    size_t count = 0;
+    if (!bit_reader.Get(count, ARCHIVE_FIXED_CHAR_SIZE)) {
+        throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+    }
+    size_t bit_count = 1 + ARCHIVE_FIXED_CHAR_SIZE;
+    std::vector<size_t> code_sizes = ReadCodeSizes(bit_reader, count, bit_count);
+
+    // Canonical order is order of symbols by their code sizes
+    CodeTable code_table;
+    for (size_t symbol = 0; symbol < count; ++symbol) {
+        if (code_sizes[symbol] > CanonicalDecoder::MAX_CODE_SIZE) {
+            throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+        }
+        if (code_sizes[symbol] > 0) {
+            code_table.order.push_back(static_cast<CharT>(symbol));
+            code_table.code_sizes_count.resize(std::max(code_table.code_sizes_count.size(), code_sizes[symbol]), 0);
+            ++code_table.code_sizes_count[code_sizes[symbol] - 1];
+        }
+    }
+    if (code_table.order.empty()) {
+        throw Decompressor::ArchiveDamagedError("Can't read compact code table");
+    }
+    std::stable_sort(code_table.order.begin(), code_table.order.end(),
+                     [&code_sizes](CharT a, CharT b) { return code_sizes[a] < code_sizes[b]; });
+    code_table.bit_count = bit_count;
+    return code_table;
+}
+
+// Build trie of canonical code from its table
+Trie<CharT> BuildTrie(const CodeTable& code_table) {
+    const std::vector<CharT>& symbols_order = code_table.order;
+    const std::vector<size_t>& size_counts = code_table.code_sizes_count;
+    size_t symbols_count = symbols_order.size();
+
+    // Recovery canonical code table
+    std::unordered_map<CharT, LongCode> canonical_codes;
+    size_t cur_size = 0;
+    while (cur_size < size_counts.size() && size_counts[cur_size] == 0) {
+        ++cur_size;
+    }
+    if (cur_size >= size_counts.size()) {
+        throw Decompressor::ArchiveDamagedError("Can't start building code table");
+    }
+    size_t cur_count_sum = size_counts[cur_size];
+
+    LongCode cur_code(cur_size + 1);
+    for (size_t i = 0; i < symbols_count; ++i) {
+        canonical_codes[symbols_order[i]] = cur_code.Copy();
+
+        if (i < symbols_count - 1) {
+            size_t new_size = cur_size;
+            while (i + 1 >= cur_count_sum) {
+                cur_count_sum += size_counts[++new_size];
+            }
+            ++cur_code;
+            cur_code = cur_code << (new_size - cur_size);
+            cur_size = new_size;
+        }
+    }
+
+    // Build trie with recovered canonical codes
+    Trie<CharT> trie;
+    for (const auto& symbol : symbols_order) {
+        trie.Add(canonical_codes[symbol], symbol);
+    }
+
+    return trie;
+}
+
+std::vector<size_t> HuffmanCodeSizes(const std::vector<size_t>& counts) {
+    using Item = std::pair<size_t, size_t>;  // Count and node
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> nodes;
+
+    // Leaves are the first nodes, every merged node is added after its children
+    std::vector<size_t> parent;
+    std::vector<size_t> leaf_node(counts.size(), 0);
+    for (size_t symbol = 0; symbol < counts.size(); ++symbol) {
+        if (counts[symbol] > 0) {
+            leaf_node[symbol] = parent.size();
+            nodes.push({counts[symbol], parent.size()});
+            parent.push_back(0);
+        }
+    }
+    while (nodes.size() >= 2) {
+        Item first = nodes.top();
+        nodes.pop();
+        Item second = nodes.top();
+        nodes.pop();
+        parent[first.second] = parent[second.second] = parent.size();
+        nodes.push({first.first + second.first, parent.size()});
+        parent.push_back(0);
+    }
+
+    // Root is the last node, so depths are known going from the end
+    std::vector<size_t> depth(parent.size(), 0);
+    for (size_t node = parent.size() - std::min<size_t>(parent.size(), 1); node-- > 0;) {
+        depth[node] = depth[parent[node]] + 1;
+    }
+
+    std::vector<size_t> sizes(counts.size(), 0);
+    for (size_t symbol = 0; symbol < counts.size(); ++symbol) {
+        if (counts[symbol] > 0) {
+            sizes[symbol] = std::max<size_t>(depth[leaf_node[symbol]], 1);
+        }
+    }
+    return sizes;
+}
+
+CanonicalDecoder::CanonicalDecoder(const CodeTable& code_table)
+    : order_(code_table.order), lookup_(static_cast<size_t>(1) << LOOKUP_BITS) {
+    const std::vector<size_t>& size_counts = code_table.code_sizes_count;
+    if (order_.size() < 2 || size_counts.size() > MAX_CODE_SIZE) {
+        throw Decompressor::ArchiveDamagedError("Unsupported code table");
+    }
+
+    // Canonical codes of size s+1 start right after codes of size s, shifted by one bit
+    first_code_.resize(size_counts.size() + 1);
+    first_index_.resize(size_counts.size() + 1);
+    sizes_count_.resize(size_counts.size() + 1);
+    uint64_t code = 0;
+    size_t index = 0;
+    for (size_t size = 1; size <= size_counts.size(); ++size) {
+        first_code_[size] = code;
+        first_index_[size] = index;
+        sizes_count_[size] = size_counts[size - 1];
+        code = (code + size_counts[size - 1]) << 1;
+        index += size_counts[size - 1];
+        if (CodesOverflow(code, size)) {
+            throw Decompressor::ArchiveDamagedError("Code table isn't prefix-free");
+        }
+    }
+    if (index != order_.size()) {
+        throw Decompressor::ArchiveDamagedError("Code table size differs from symbols count");
+    }
+
+    // Every short code fills all lookup entries, which start with it
+    for (size_t size = 1; size <= std::min(LOOKUP_BITS, size_counts.size()); ++size) {
+        for (size_t i = 0; i < sizes_count_[size]; ++i) {
+            size_t start = (first_code_[size] + i) << (LOOKUP_BITS - size);
+            size_t end = start + (static_cast<size_t>(1) << (LOOKUP_BITS - size));
+            for (size_t entry = start; entry < end && entry < lookup_.size(); ++entry) {
+                lookup_[entry] = {.symbol = order_[first_index_[size] + i], .code_size = static_cast<uint8_t>(size)};
+            }
+        }
+    }
+}
+
+CharT CanonicalDecoder::Decode(uint64_t window, size_t& code_size) const {
+    const LookupEntry& entry = lookup_[window >> (64 - LOOKUP_BITS)];
+    if (entry.code_size > 0) {
+        code_size = entry.code_size;
+        return entry.symbol;
+    }
+
+    for (size_t size = LOOKUP_BITS + 1; size < first_code_.size(); ++size) {
+        uint64_t code = window >> (64 - size);
+        if (code - first_code_[size] < sizes_count_[size]) {
+            code_size = size;
+            return order_[first_index_[size] + (code - first_code_[size])];
+        }
+    }
+    throw Decompressor::ArchiveDamagedError("Can't decode char code");
+}
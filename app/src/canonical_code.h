@@ -4,9 +4,12 @@
 #include <array>
 #include <memory>
 #include <tuple>
+#include <vector>
 
 #include "long_code.h"
 #include "service_symbols.h"
+#include "utils/bit_reader.h"
+#include "utils/bit_writer.h"
 #include "utils/counter.h"
 #include "utils/priority_queue.h"
 #include "utils/trie.h"
@@ -19,15 +22,76 @@ public:
     size_t Size() const;
 
     LongCode& operator[](const T& t);
+    const LongCode& operator[](const T& t) const;
     std::vector<T> Order() const;
     std::vector<size_t> CodeSizesCount() const;
 
 private:
-    std::array<LongCode, MAX_CHAR_VALUE + 1> translate_;
+    std::vector<LongCode> translate_;  // Codes of symbols up to the greatest one, alphabet may exceed MAX_CHAR_VALUE
     std::vector<T> order_;
     std::vector<size_t> code_sizes_count_;
 };
 
+// Table of canonical code in archive: symbols count, symbols in canonical codes order and counts of code sizes
+struct CodeTable {
+    std::vector<CharT> order;
+    std::vector<size_t> code_sizes_count;
+    size_t bit_count = 0;  // Size of table in archive, it is written in full or in compact form
+
+    size_t BitCount() const;
+};
+
+void WriteCodeTable(BitWriter& bit_writer, const CanonicalCodeGenerator<CharT>& canonical_code);
+CodeTable ReadCodeTable(BitReader& bit_reader);
+
+// Compact table: code sizes of all symbols up to the greatest one, coded by runs and by Huffman code of code sizes
+// like in deflate. Table, that is equal to the previous table of the same block, is written as one flag bit
+void WriteCompactCodeTable(BitWriter& bit_writer, const CanonicalCodeGenerator<CharT>& canonical_code,
+                           const CanonicalCodeGenerator<CharT>* previous = nullptr);
+CodeTable ReadCompactCodeTable(BitReader& bit_reader, const CodeTable* previous = nullptr);
+size_t CompactCodeTableBitCount(const std::vector<size_t>& code_sizes);
+
+// Code sizes of compact table without their count, that codes of larger alphabets may use. Writer returns size in
+// bits and only measures it, if bit_writer is nullptr; reader adds size to bit_count
+size_t WriteCodeSizes(BitWriter* bit_writer, const std::vector<size_t>& code_sizes);
+std::vector<size_t> ReadCodeSizes(BitReader& bit_reader, size_t count, size_t& bit_count);
+Trie<CharT> BuildTrie(const CodeTable& code_table);
+
+// Sizes of Huffman codes of symbols with given counts, that are enough to estimate size of encoded data without
+// building the code
+std::vector<size_t> HuffmanCodeSizes(const std::vector<size_t>& counts);
+
+// Check of Kraft inequality while canonical codes are assigned: code is the first code after all codes of size and
+// smaller ones, shifted by one bit, and it may not exceed 2^(size+1), otherwise table is overfull
+inline bool CodesOverflow(uint64_t code, size_t size) {
+    return size < 63 && code > (uint64_t{2} << size);
+}
+
+// Table-driven decoder of canonical code: the next LOOKUP_BITS bits give symbol and its code size at once, longer
+// codes are found by ranges of canonical codes of every size
+class CanonicalDecoder {
+public:
+    static constexpr size_t LOOKUP_BITS = 10;
+    static constexpr size_t MAX_CODE_SIZE = 56;
+
+    explicit CanonicalDecoder(const CodeTable& code_table);
+
+    // Decode symbol from the highest MAX_CODE_SIZE bits of window and return size of its code in code_size
+    CharT Decode(uint64_t window, size_t& code_size) const;
+
+private:
+    struct LookupEntry {
+        CharT symbol = 0;
+        uint8_t code_size = 0;  // Zero for codes longer than LOOKUP_BITS
+    };
+
+    std::vector<CharT> order_;
+    std::vector<uint64_t> first_code_;   // The first canonical code of every size
+    std::vector<size_t> first_index_;    // Index of symbol with the first code of every size in order_
+    std::vector<size_t> sizes_count_;    // Count of codes of every size
+    std::vector<LookupEntry> lookup_;
+};
+
 template <typename T>
 struct Symbol {
     T t;
@@ -73,6 +137,12 @@ CanonicalCodeGenerator<T>::CanonicalCodeGenerator(Counter<T>& counter) {
     std::sort(symbols.begin(), symbols.end(), SymbolComp<T>);
 
     // Build canonical huffman code
+    T max_symbol = MAX_CHAR_VALUE;
+    for (const auto& symbol : symbols) {
+        max_symbol = std::max(max_symbol, symbol.t);
+    }
+    translate_.resize(static_cast<size_t>(max_symbol) + 1);
+
     LongCode current_code(symbols[0].code.Size());
     code_sizes_count_.resize(symbols.back().code.Size());
     for (size_t i = 0; i < symbols.size(); ++i) {
@@ -92,6 +162,11 @@ LongCode& CanonicalCodeGenerator<T>::operator[](const T& t) {
     return translate_[t];
 }
 
+template <typename T>
+const LongCode& CanonicalCodeGenerator<T>::operator[](const T& t) const {
+    return translate_[t];
+}
+
 // Number of symbols in alphabet
 template <typename T>
 size_t CanonicalCodeGenerator<T>::Size() const {
@@ -1,13 +1,33 @@
 #include "compressor.h"
 
+#include <array>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <ios>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 
+#include "archive_index.h"
+#include "block_codec.h"
 #include "canonical_code.h"
+#include "encode_pipeline.h"
 #include "service_symbols.h"
 #include "utils/bit_reader.h"
 #include "utils/bit_writer.h"
 #include "utils/counter.h"
+#include "utils/hash.h"
+
+// Deduplication and codecs other than order-0 Huffman code are supported only by indexed archives
+bool CompressionOptions::NeedsIndex() const {
+    return indexed || dedup || block.order1 || block.lz77 || block.bwt || block.tans || block.words ||
+           block.filters || block.speed_weight != 0 || block.split || solid ||
+           block_size != EncodePipeline::BLOCK_SIZE;
+}
 
 // Get total weight of archive
 Weight Compressor::ResultWeight() const {
@@ -19,79 +39,493 @@ Weight Compressor::RawWeight() const {
     return raw_weight_;
 }
 
+// Get count of files, that were stored as references to identical files
+size_t Compressor::DuplicatesCount() const {
+    return duplicates_count_;
+}
+
 void DeleteFile(const std::string path) {
-    char* remove_file_path = new char[path.size()];
-    std::strcpy(remove_file_path, path.c_str());
-    std::remove(remove_file_path);
-    delete[] remove_file_path;
+    std::remove(path.c_str());
+}
+
+// Canonical code of one file, that is built from histograms of its blocks
+struct FileCode {
+    std::mutex mutex;
+    std::array<size_t, 1 << FILE_FIXED_CHAR_SIZE> counts = {};
+    size_t pending_blocks = 0;
+    std::exception_ptr error;
+
+    Stats* stats = nullptr;
+    size_t stats_file = Stats::NO_FILE;
+    FileProgress* progress = nullptr;
+
+    std::unique_ptr<CanonicalCodeGenerator<CharT>> canonical_code;
+    std::promise<void> promise;
+    std::shared_future<void> ready = promise.get_future().share();
+};
+
+// Read size bytes of file starting from offset
+std::string ReadBlock(const std::string& path, size_t offset, size_t size) {
+    std::ifstream stream(path, std::ios::binary | std::ios::in);
+    if (stream.fail()) {
+        throw FileBitReader::FileNotExists(path);
+    }
+    std::string block(size, '\0');
+    stream.seekg(static_cast<std::streamoff>(offset));
+    stream.read(block.data(), static_cast<std::streamsize>(size));
+    block.resize(stream.gcount());
+    return block;
+}
+
+// Add histogram of one block, the last block builds canonical code of file
+void AddBlockCounts(FileCode& file_code, const File& file, const std::array<size_t, 1 << FILE_FIXED_CHAR_SIZE>& counts,
+                    std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(file_code.mutex);
+        for (size_t c = 0; c < counts.size(); ++c) {
+            file_code.counts[c] += counts[c];
+        }
+        if (error) {
+            file_code.error = error;
+        }
+        if (--file_code.pending_blocks > 0) {
+            return;
+        }
+    }
+
+    if (file_code.error) {
+        file_code.promise.set_exception(file_code.error);
+        return;
+    }
+
+    try {
+        StageTimer timer(file_code.stats, Stage::TABLE);
+        size_t file_size = 0;
+        for (size_t count : file_code.counts) {
+            file_size += count;
+        }
+
+        // Counting the number of all characters
+        Counter<CharT> counter;
+        for (char c : file.GetName()) {
+            counter.Add(c);
+        }
+        for (size_t c = 0; c < file_code.counts.size(); ++c) {
+            if (file_code.counts[c] > 0) {
+                counter.Add(static_cast<CharT>(c), file_code.counts[c]);
+            }
+        }
+        counter.Add(FILENAME_END);
+        counter.Add(ONE_MORE_FILE);
+        counter.Add(ARCHIVE_END);
+
+        file_code.canonical_code = std::make_unique<CanonicalCodeGenerator<CharT>>(counter);
+        timer.Stop(file_code.stats_file, file_size, 0);
+        file_code.promise.set_value();
+    } catch (...) {
+        file_code.promise.set_exception(std::current_exception());
+    }
+}
+
+// Table of canonical code and encoded file name
+EncodedBlock EncodeFileHeader(const CanonicalCodeGenerator<CharT>& canonical_code, const File& file) {
+    StringBitWriter bit_writer;
+    WriteCodeTable(bit_writer, canonical_code);
+    for (char c : file.GetName()) {
+        bit_writer.Write(canonical_code[c]);
+    }
+    bit_writer.Write(canonical_code[FILENAME_END]);
+
+    return TakeBlock(bit_writer);
+}
+
+// Sizes of given files, throw if some file doesn't exist
+std::vector<size_t> Compressor::FileSizes() const {
+    std::vector<size_t> file_sizes;
+    for (const auto& file : files_) {
+        FileBitReader reader(file.GetPath());
+        file_sizes.push_back(std::filesystem::file_size(file.GetPath()));
+    }
+    return file_sizes;
+}
+
+// Check that files of the same size have the same content
+bool SameContent(const std::string& first_path, const std::string& second_path, size_t size) {
+    for (size_t offset = 0; offset < size; offset += EncodePipeline::BLOCK_SIZE) {
+        if (ReadBlock(first_path, offset, EncodePipeline::BLOCK_SIZE) !=
+            ReadBlock(second_path, offset, EncodePipeline::BLOCK_SIZE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// For every file find the first given file with the same content, unique files refer to themselves.
+// Files are hashed by thread pool jobs, files with equal sizes and hashes are compared completely
+std::vector<size_t> Compressor::FindDuplicates(const std::vector<size_t>& file_sizes,
+                                               const std::vector<FileProgress*>& progress_files) {
+    std::vector<std::future<uint64_t>> hashes;
+    for (size_t file_index = 0; file_index < files_.size(); ++file_index) {
+        hashes.push_back(pool_.Submit([path = files_[file_index].GetPath(), size = file_sizes[file_index],
+                                       progress = progress_files[file_index]] {
+            uint64_t hash = 0;
+            for (size_t offset = 0; offset < size; offset += EncodePipeline::BLOCK_SIZE) {
+                std::string block = ReadBlock(path, offset, EncodePipeline::BLOCK_SIZE);
+                hash = Hash(block, hash);
+                Progress::Add(progress, block.size());
+            }
+            return hash;
+        }));
+    }
+
+    std::vector<size_t> originals(files_.size());
+    std::map<std::pair<size_t, uint64_t>, std::vector<size_t>> uniques;
+    for (size_t file_index = 0; file_index < files_.size(); ++file_index) {
+        originals[file_index] = file_index;
+        auto& candidates = uniques[{file_sizes[file_index], hashes[file_index].get()}];
+        for (size_t candidate : candidates) {
+            if (SameContent(files_[candidate].GetPath(), files_[file_index].GetPath(), file_sizes[file_index])) {
+                originals[file_index] = candidate;
+                break;
+            }
+        }
+        if (originals[file_index] == file_index) {
+            candidates.push_back(file_index);
+        }
+    }
+    return originals;
+}
+
+// Add files to stats and return index of the first of them
+size_t Compressor::AddStatsFiles(const std::vector<size_t>& file_sizes) const {
+    size_t first_file = 0;
+    for (size_t file_index = 0; stats_ != nullptr && file_index < files_.size(); ++file_index) {
+        size_t stats_file = stats_->AddFile(files_[file_index].GetName(), file_sizes[file_index]);
+        if (file_index == 0) {
+            first_file = stats_file;
+        }
+    }
+    return first_file;
+}
+
+// Add files to progress and return their counters, which are null without progress. Every pass over data of file is
+// counted, so total of file is its size times count of passes
+std::vector<FileProgress*> Compressor::AddProgressFiles(const std::vector<size_t>& file_sizes,
+                                                        size_t passes_count) const {
+    std::vector<FileProgress*> progress_files(files_.size());
+    for (size_t file_index = 0; progress_ != nullptr && file_index < files_.size(); ++file_index) {
+        progress_files[file_index] =
+            progress_->AddFile(files_[file_index].GetName(), file_sizes[file_index] * passes_count);
+    }
+    return progress_files;
+}
+
+// Read block of file as stage of stats
+static std::string ReadStatsBlock(Stats* stats, size_t stats_file, const std::string& path, size_t offset,
+                                  size_t size) {
+    StageTimer timer(stats, Stage::READ);
+    std::string block = ReadBlock(path, offset, size);
+    timer.Stop(stats_file, block.size(), block.size());
+    return block;
+}
+
+// Encode block of indexed archive as stage of stats
+static EncodedBlock EncodeStatsBlock(Stats* stats, size_t stats_file, const std::string& data,
+                                     const BlockEncoderOptions& options) {
+    StageTimer timer(stats, Stage::ENCODE);
+    std::string block = EncodeBlocks(data, options);
+    timer.Stop(stats_file, data.size(), block.size());
+
+    // Count codecs of blocks, that data was split into
+    for (size_t offset = 0; stats != nullptr && offset + BlockHeader::SIZE <= block.size();) {
+        std::istringstream stream(block.substr(offset, BlockHeader::SIZE));
+        BitReader bit_reader(stream);
+        BlockHeader header = BlockHeader::Read(bit_reader);
+        stats->AddCodec(stats_file, FindBlockCoder(header.codec).Name());
+        offset += BlockHeader::SIZE + header.size;
+    }
+    return EncodedBlock{.bytes = block, .bit_count = block.size() * 8};
 }
 
 // Compress given files and save compressed data in archive
 void Compressor::Compress() {
+    std::vector<size_t> file_sizes = FileSizes();
+
     FileBitWriter bit_writer(archive_path);
 
+    try {
+        if (options_.NeedsIndex()) {
+            ArchiveIndex index;
+            ArchiveIndex::WriteHeader(bit_writer);
+            WriteEntries(bit_writer, index, file_sizes);
+        } else {
+            WriteStream(bit_writer, file_sizes);
+        }
+    } catch (const FileBitReader::FileNotExists& e) {
+        bit_writer.Close();
+        DeleteFile(archive_path);
+        throw;
+    }
+
+    // Save compress weight result
+    result_weight_ = Weight(bit_writer.ByteCount());
+}
+
+// Add given files to indexed archive, blocks of existing entries are left untouched. New blocks are written over the
+// old index of a copy of archive, and the copy replaces archive only after the new index is complete, so archive stays
+// readable, if appending fails or the process is killed. Archive is created if it doesn't exist
+void Compressor::Append() {
+    if (!std::filesystem::exists(archive_path)) {
+        options_.indexed = true;
+        Compress();
+        return;
+    }
+    if (!ArchiveIndex::IsIndexed(archive_path)) {
+        throw ArchiveNotIndexedError(archive_path);
+    }
+    if (!std::fstream(archive_path, std::ios::binary | std::ios::in | std::ios::out).is_open()) {
+        throw ArchiveNotWritableError(archive_path);
+    }
+
+    std::vector<size_t> file_sizes = FileSizes();
+    ArchiveIndex index = ArchiveIndex::Read(archive_path);
+    const std::string temporary_path = archive_path + TEMPORARY_SUFFIX;
+
+    try {
+        std::filesystem::copy_file(archive_path, temporary_path, std::filesystem::copy_options::overwrite_existing);
+        std::fstream stream(temporary_path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!stream.is_open()) {
+            throw ArchiveNotWritableError(temporary_path);
+        }
+
+        // Archive of older version is upgraded, its index is rewritten anyway
+        if (index.Version() != ArchiveIndex::VERSION) {
+            index.SetVersion(ArchiveIndex::VERSION);
+            stream.seekp(0);
+            BitWriter header_writer(stream);
+            ArchiveIndex::WriteHeader(header_writer);
+            header_writer.Complete();
+        }
+
+        stream.seekp(static_cast<std::streamoff>(index.Offset()));
+        BitWriter bit_writer(stream);
+        WriteEntries(bit_writer, index, file_sizes);
+        stream.close();
+        if (stream.fail()) {
+            throw ArchiveNotWritableError(temporary_path);
+        }
+        std::filesystem::rename(temporary_path, archive_path);
+    } catch (...) {
+        DeleteFile(temporary_path);
+        throw;
+    }
+
+    result_weight_ = Weight(std::filesystem::file_size(archive_path));
+}
+
+// Write files in stream format: every file has own canonical code and is encoded together with its name.
+// Histograms and encoding of every block of every file are thread pool jobs, archive is written in order
+void Compressor::WriteStream(BitWriter& bit_writer, const std::vector<size_t>& file_sizes) {
+    const size_t first_stats_file = AddStatsFiles(file_sizes);
+    // Every file is read twice: for histogram and for encoding
+    const std::vector<FileProgress*> progress_files = AddProgressFiles(file_sizes, 2);
+
+    // Counting the number of all characters of every block
+    std::vector<std::shared_ptr<FileCode>> file_codes;
     for (size_t file_index = 0; file_index < files_.size(); ++file_index) {
+        auto file_code = std::make_shared<FileCode>();
+        size_t blocks_count = std::max<size_t>(1, (file_sizes[file_index] + EncodePipeline::BLOCK_SIZE - 1) /
+                                                      EncodePipeline::BLOCK_SIZE);
+        file_code->pending_blocks = blocks_count;
+        file_code->stats = stats_;
+        file_code->stats_file = first_stats_file + file_index;
+        file_code->progress = progress_files[file_index];
+        file_codes.push_back(file_code);
+
+        for (size_t block = 0; block < blocks_count; ++block) {
+            pool_.Submit([file_code, file = files_[file_index], block] {
+                std::array<size_t, 1 << FILE_FIXED_CHAR_SIZE> counts = {};
+                std::exception_ptr error;
+                try {
+                    std::string chunk = ReadStatsBlock(file_code->stats, file_code->stats_file, file.GetPath(),
+                                                       block * EncodePipeline::BLOCK_SIZE, EncodePipeline::BLOCK_SIZE);
+                    StageTimer timer(file_code->stats, Stage::HISTOGRAM);
+                    for (char c : chunk) {
+                        ++counts[static_cast<unsigned char>(c)];
+                    }
+                    timer.Stop(file_code->stats_file, chunk.size(), 0);
+                    Progress::Add(file_code->progress, chunk.size());
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                AddBlockCounts(*file_code, file, counts, error);
+            });
+        }
+        raw_weight_ += file_sizes[file_index];
+    }
+
+    // Encode file data and write it in order
+    EncodePipeline pipeline(pool_, bit_writer, stats_);
+    for (size_t file_index = 0; file_index < files_.size(); ++file_index) {
+        const auto& file_code = file_codes[file_index];
         const File& file = files_[file_index];
 
-        try {
+        pipeline.Add(file_code->stats_file, file_code->ready, [file_code, file] {
+            file_code->ready.get();
+            StageTimer timer(file_code->stats, Stage::ENCODE);
+            EncodedBlock block = EncodeFileHeader(*file_code->canonical_code, file);
+            timer.Stop(file_code->stats_file, file.GetName().size(), block.bytes.size());
+            return block;
+        });
 
-            // Counting the number of all characters
-            FileBitReader reader(file.GetPath());
-            Counter<CharT> counter;
+        for (size_t offset = 0; offset < file_sizes[file_index]; offset += EncodePipeline::BLOCK_SIZE) {
+            pipeline.Add(file_code->stats_file, file_code->ready, [file_code, path = file.GetPath(), offset] {
+                file_code->ready.get();
+                std::string chunk = ReadStatsBlock(file_code->stats, file_code->stats_file, path, offset,
+                                                   EncodePipeline::BLOCK_SIZE);
+                StageTimer timer(file_code->stats, Stage::ENCODE);
+                EncodedBlock block = EncodePipeline::Encode(chunk, *file_code->canonical_code);
+                timer.Stop(file_code->stats_file, chunk.size(), block.bytes.size());
+                Progress::Add(file_code->progress, chunk.size());
+                return block;
+            });
+        }
 
-            for (char c : file.GetName()) {
-                counter.Add(c);
-            }
+        bool last_file = file_index + 1 == files_.size();
+        pipeline.Add(file_code->stats_file, file_code->ready, [file_code, last_file] {
+            file_code->ready.get();
+            StringBitWriter bit_writer;
+            bit_writer.Write((*file_code->canonical_code)[last_file ? ARCHIVE_END : ONE_MORE_FILE]);
+            return TakeBlock(bit_writer);
+        });
+    }
+    pipeline.Finish();
+}
 
-            counter.Process(reader, FILE_FIXED_CHAR_SIZE);
-            counter.Add(FILENAME_END);
-            counter.Add(ONE_MORE_FILE);
-            counter.Add(ARCHIVE_END);
+// Write blocks of files starting from index offset, add files to index and write index after blocks.
+// Every block is compressed independently by thread pool job. In solid mode runs of small files are concatenated
+// into groups of no more than block size, entries of group refer to its blocks and their positions in it
+void Compressor::WriteEntries(BitWriter& bit_writer, ArchiveIndex& index, const std::vector<size_t>& file_sizes) {
+    uint64_t position = index.Offset();
 
-            raw_weight_ += reader.ByteCount();
+    // With dedup every file is read for hash before encoding
+    const std::vector<FileProgress*> progress_files = AddProgressFiles(file_sizes, options_.dedup ? 2 : 1);
+    std::vector<size_t> originals;
+    if (options_.dedup) {
+        originals = FindDuplicates(file_sizes, progress_files);
+    }
+    const size_t first_entry = index.Entries().size();
+    const size_t first_stats_file = AddStatsFiles(file_sizes);
 
-            CanonicalCodeGenerator canonical_code(counter);
+    EncodePipeline pipeline(pool_, bit_writer, stats_);
 
-            // Write file data
-            bit_writer.Write(canonical_code.Size(), ARCHIVE_FIXED_CHAR_SIZE);
-            for (const auto& character : canonical_code.Order()) {
-                bit_writer.Write(character, ARCHIVE_FIXED_CHAR_SIZE);
-            }
-            for (const auto& size_count : canonical_code.CodeSizesCount()) {
-                bit_writer.Write(size_count, ARCHIVE_FIXED_CHAR_SIZE);
-            }
-            for (char c : file.GetName()) {
-                bit_writer.Write(canonical_code[c]);
-            }
-            bit_writer.Write(canonical_code[FILENAME_END]);
+    // Small files of the current solid group
+    std::vector<size_t> group;
+    size_t group_size = 0;
+    auto add_group = [&] {
+        if (group.empty()) {
+            return;
+        }
+        std::vector<std::pair<std::string, size_t>> group_files;
+        std::vector<std::pair<FileProgress*, size_t>> group_progress;
+        for (size_t file_index : group) {
+            group_files.emplace_back(files_[file_index].GetPath(), file_sizes[file_index]);
+            group_progress.emplace_back(progress_files[file_index], file_sizes[file_index]);
+        }
+        // Stages of group are counted in its first file
+        size_t stats_file = first_stats_file + group.front();
+        pipeline.Add(
+            stats_file, {},
+            [group_files, group_progress, block_options = options_.block, stats = stats_, stats_file] {
+                std::string data;
+                for (const auto& [path, size] : group_files) {
+                    data += ReadStatsBlock(stats, stats_file, path, 0, size);
+                }
+                EncodedBlock block = EncodeStatsBlock(stats, stats_file, data, block_options);
+                for (const auto& [progress, size] : group_progress) {
+                    Progress::Add(progress, size);
+                }
+                return block;
+            },
+            [&index, &position, first_entry, group](const EncodedBlock& block) {
+                for (size_t file_index : group) {
+                    IndexEntry& entry = index.Entries()[first_entry + file_index];
+                    entry.offset = position;
+                    entry.size = block.bytes.size();
+                }
+                position += block.bytes.size();
+            });
+        group.clear();
+        group_size = 0;
+    };
 
-            // Write file content
-            reader.Reset();
-            CharT c = 0;
-            while (reader.Get(c, FILE_FIXED_CHAR_SIZE)) {
-                bit_writer.Write(canonical_code[c]);
-            }
+    for (size_t file_index = 0; file_index < files_.size(); ++file_index) {
+        const File& file = files_[file_index];
+        size_t entry_index = index.Entries().size();
+        index.Add({.name = file.GetName(), .raw_size = file_sizes[file_index], .offset = position, .size = 0});
+        raw_weight_ += file_sizes[file_index];
 
-            if (file_index < files_.size() - 1) {
-                bit_writer.Write(canonical_code[ONE_MORE_FILE]);
-            } else {
-                bit_writer.Write(canonical_code[ARCHIVE_END]);
+        // Duplicate gets blocks of its original after they are written
+        if (!originals.empty() && originals[file_index] != file_index) {
+            ++duplicates_count_;
+            Progress::Add(progress_files[file_index], file_sizes[file_index]);
+            continue;
+        }
+
+        if (options_.solid && file_sizes[file_index] < CompressionOptions::SOLID_MAX_FILE_SIZE) {
+            if (group_size + file_sizes[file_index] > options_.block_size) {
+                add_group();
             }
+            index.Entries()[entry_index].skip = group_size;
+            group.push_back(file_index);
+            group_size += file_sizes[file_index];
+            continue;
+        }
+        add_group();
 
-        } catch (const FileBitReader::FileNotExists& e) {
-            DeleteFile(archive_path);
-            throw;
+        for (size_t offset = 0; offset < file_sizes[file_index]; offset += options_.block_size) {
+            size_t stats_file = first_stats_file + file_index;
+            pipeline.Add(
+                stats_file, {},
+                [path = file.GetPath(), offset, block_options = options_.block, block_size = options_.block_size,
+                 stats = stats_, stats_file, progress = progress_files[file_index]] {
+                    std::string data = ReadStatsBlock(stats, stats_file, path, offset, block_size);
+                    EncodedBlock block = EncodeStatsBlock(stats, stats_file, data, block_options);
+                    Progress::Add(progress, data.size());
+                    return block;
+                },
+                [&index, &position, entry_index](const EncodedBlock& block) {
+                    IndexEntry& entry = index.Entries()[entry_index];
+                    if (entry.size == 0) {
+                        entry.offset = position;
+                    }
+                    entry.size += block.bytes.size();
+                    position += block.bytes.size();
+                });
         }
     }
+    add_group();
+    pipeline.Finish();
 
-    bit_writer.Complete();
+    for (size_t file_index = 0; file_index < originals.size(); ++file_index) {
+        IndexEntry& entry = index.Entries()[first_entry + file_index];
+        const IndexEntry& original = index.Entries()[first_entry + originals[file_index]];
+        entry.offset = original.offset;
+        entry.size = original.size;
+        entry.skip = original.skip;
+    }
 
-    // Save compress weight result
-    result_weight_ = Weight(bit_writer.ByteCount());
+    StageTimer timer(stats_, Stage::WRITE);
+    index.SetOffset(position);
+    index.Write(bit_writer);
+    bit_writer.Complete();
+    timer.Stop(Stats::NO_FILE, 0, 0);
 }
 
 // Compressor constructor
-Compressor::Compressor(std::vector<std::string>& files, const std::string& archive_name) : archive_path(archive_name) {
+Compressor::Compressor(std::vector<std::string>& files, const std::string& archive_name, ThreadPool& pool,
+                       const CompressionOptions& options, Stats* stats, Progress* progress)
+    : archive_path(archive_name), pool_(pool), options_(options), stats_(stats), progress_(progress) {
     files_.resize(files.size());
     for (size_t file_index = 0; file_index < files.size(); ++file_index) {
         files_[file_index] = File(files[file_index]);
@@ -102,3 +536,31 @@ Compressor::Compressor(std::vector<std::string>& files, const std::string& archi
 void Compressor::AddFile(std::string& file) {
     files_.push_back(File(file));
 }
+
+// Exceptions
+
+// Constructor of ArchiveNotIndexedError
+Compressor::ArchiveNotIndexedError::ArchiveNotIndexedError(const std::string& archive_path) {
+    std::string full_description = "Archive \"" + archive_path +
+                                   "\" has no index, files can be appended only to archives created with -a or "
+                                   "--indexed.";
+    description_ = new char[full_description.size() + 1];
+    std::strcpy(description_, full_description.c_str());
+}
+
+// Return more information about ArchiveNotIndexedError exception
+const char* Compressor::ArchiveNotIndexedError::what() const noexcept {
+    return description_;
+}
+
+// Constructor of ArchiveNotWritableError
+Compressor::ArchiveNotWritableError::ArchiveNotWritableError(const std::string& archive_path) {
+    std::string full_description = "Can't write archive \"" + archive_path + "\".";
+    description_ = new char[full_description.size() + 1];
+    std::strcpy(description_, full_description.c_str());
+}
+
+// Return more information about ArchiveNotWritableError exception
+const char* Compressor::ArchiveNotWritableError::what() const noexcept {
+    return description_;
+}
@@ -3,26 +3,88 @@
 #include <string>
 #include <vector>
 
+#include "archive_index.h"
+#include "block_codec.h"
+#include "encode_pipeline.h"
 #include "service_symbols.h"
+#include "utils/bit_writer.h"
 #include "utils/file.h"
+#include "utils/progress.h"
+#include "utils/stats.h"
+#include "utils/thread_pool.h"
 #include "utils/weight.h"
 
+// Settings of compression
+struct CompressionOptions {
+    static constexpr size_t MIN_BLOCK_SIZE = 1 << 16;
+    static constexpr size_t MAX_BLOCK_SIZE = 1 << 23;
+    static constexpr size_t SOLID_MAX_FILE_SIZE = 1 << 16;  // Only smaller files are compressed in solid groups
+
+    bool indexed = false;  // Write archive with index of entries, that allows appending files
+    bool dedup = false;    // Store identical files once, entries of duplicates refer to the same blocks
+    bool solid = false;    // Compress runs of small files together, so that they share blocks and code tables
+    BlockEncoderOptions block;
+    size_t block_size = EncodePipeline::BLOCK_SIZE;  // Size of independently compressed blocks of indexed archive
+
+    bool NeedsIndex() const;
+};
+
 class Compressor {
 public:
+    class ArchiveNotIndexedError : public std::exception {
+    public:
+        explicit ArchiveNotIndexedError(const std::string& archive_path);
+
+        const char* what() const noexcept override;
+
+    private:
+        char* description_;
+    };
+
+    class ArchiveNotWritableError : public std::exception {
+    public:
+        explicit ArchiveNotWritableError(const std::string& archive_path);
+
+        const char* what() const noexcept override;
+
+    private:
+        char* description_;
+    };
+
+    static constexpr const char* TEMPORARY_SUFFIX = ".tmp";  // Copy of archive, that files are appended to
+
     const std::string archive_path;
 
 public:
-    explicit Compressor(std::vector<std::string>& files, const std::string& archive_name = "result.arc");
+    Compressor(std::vector<std::string>& files, const std::string& archive_name, ThreadPool& pool,
+               const CompressionOptions& options = CompressionOptions(), Stats* stats = nullptr,
+               Progress* progress = nullptr);
 
     void AddFile(std::string& file);
 
     void Compress();
+    void Append();
 
     Weight ResultWeight() const;
     Weight RawWeight() const;
+    size_t DuplicatesCount() const;
 
 private:
+    std::vector<size_t> FileSizes() const;
+    std::vector<size_t> FindDuplicates(const std::vector<size_t>& file_sizes,
+                                       const std::vector<FileProgress*>& progress_files);
+    size_t AddStatsFiles(const std::vector<size_t>& file_sizes) const;
+    std::vector<FileProgress*> AddProgressFiles(const std::vector<size_t>& file_sizes, size_t passes_count) const;
+
+    void WriteStream(BitWriter& bit_writer, const std::vector<size_t>& file_sizes);
+    void WriteEntries(BitWriter& bit_writer, ArchiveIndex& index, const std::vector<size_t>& file_sizes);
+
     std::vector<File> files_;
+    ThreadPool& pool_;
+    CompressionOptions options_;
+    Stats* stats_;        // Stages are measured, if stats are given
+    Progress* progress_;  // Encoded bytes are counted, if progress is given
     Weight result_weight_;
     Weight raw_weight_;
+    size_t duplicates_count_ = 0;
 };
@@ -1,80 +1,43 @@
 #include "decompressor.h"
 
-#include <cstring>
-#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
 #include <vector>
 
+#include "archive_index.h"
+#include "block_codec.h"
+#include "canonical_code.h"
 #include "long_code.h"
 #include "service_symbols.h"
 #include "utils/bit_reader.h"
 #include "utils/bit_writer.h"
+#include "utils/ordered_pipeline.h"
 #include "utils/trie.h"
 
+// Decompress all files of archive into the current directory
 void Decompressor::Decompress() {
-    FileBitReader bit_reader(archive_file_.GetPath());
-
-    while (true) {
-        size_t symbols_count = 0;
-
-        // Read symbols count
-        bit_reader.Get(symbols_count, ARCHIVE_FIXED_CHAR_SIZE);
-
-        // Read symbols order
-        std::vector<CharT> symbols_order(symbols_count);
-        for (size_t i = 0; i < symbols_count; ++i) {
-            CharT symbol = 0;
-            if (!bit_reader.Get(symbol, ARCHIVE_FIXED_CHAR_SIZE)) {
-                throw ArchiveDamagedError("Can't read symbols order");
-            }
-            symbols_order[i] = symbol;
-        }
-
-        // Read code sizes count
-        size_t sum_size_count = 0;
-        std::vector<size_t> size_counts;
-        while (sum_size_count < symbols_count) {
-            size_t size_count = 0;
-            if (!bit_reader.Get(size_count, ARCHIVE_FIXED_CHAR_SIZE)) {
-                break;
-            }
-            sum_size_count += size_count;
-            size_counts.push_back(size_count);
-        }
-        if (sum_size_count != symbols_count) {
-            throw ArchiveDamagedError("Can't read code sizes count");
-        }
-
-        // Recovery canonical code table
-        std::unordered_map<CharT, LongCode> canonical_codes;
-        size_t cur_size = 0;
-        while (cur_size < size_counts.size() && size_counts[cur_size] == 0) {
-            ++cur_size;
-        }
-        if (cur_size >= size_counts.size()) {
-            throw ArchiveDamagedError("Can't start building code table");
-        }
-        size_t cur_count_sum = size_counts[cur_size];
+    if (ArchiveIndex::IsIndexed(archive_file_.GetPath())) {
+        DecompressIndexed();
+    } else {
+        DecompressStream();
+    }
+}
 
-        LongCode cur_code(cur_size + 1);
-        for (size_t i = 0; i < symbols_count; ++i) {
-            canonical_codes[symbols_order[i]] = cur_code.Copy();
+// Decompress archive of one bitstream, where every file is encoded together with its name. Bits are read, decoded
+// and written one by one, so for stats reading and writing of content are parts of decoding. Sizes of files aren't
+// known before their end, so progress is counted by PROGRESS_STEP bytes without total
+void Decompressor::DecompressStream() {
+    static constexpr size_t PROGRESS_STEP = 1 << 16;
 
-            if (i < symbols_count - 1) {
-                size_t new_size = cur_size;
-                while (i + 1 >= cur_count_sum) {
-                    cur_count_sum += size_counts[++new_size];
-                }
-                ++cur_code;
-                cur_code = cur_code << (new_size - cur_size);
-                cur_size = new_size;
-            }
-        }
+    FileBitReader bit_reader(archive_file_.GetPath());
 
-        // Build trie with recovered canonical codes
-        Trie<CharT> trie;
-        for (const auto& symbol : symbols_order) {
-            trie.Add(canonical_codes[symbol], symbol);
-        }
+    while (true) {
+        // Table and name precede content of file
+        StageTimer table_timer(stats_, Stage::TABLE);
+        size_t table_start = bit_reader.ByteCount();
+        Trie<CharT> trie = BuildTrie(ReadCodeTable(bit_reader));
 
         // Read and decompress file name
         std::string file_name;
@@ -98,6 +61,9 @@ void Decompressor::Decompress() {
         if (!filename_end) {
             return throw ArchiveDamagedError("Can't read file_name");
         }
+        size_t stats_file = stats_ != nullptr ? stats_->AddFile(file_name) : Stats::NO_FILE;
+        table_timer.Stop(stats_file, bit_reader.ByteCount() - table_start, 0);
+        FileProgress* progress_file = progress_ != nullptr ? progress_->AddFile(file_name) : nullptr;
 
         bool one_more_file = false;
         bool archive_end = false;
@@ -107,6 +73,8 @@ void Decompressor::Decompress() {
         size_t file_size = 0;
 
         // Read and decompress file content
+        StageTimer decode_timer(stats_, Stage::DECODE);
+        size_t content_start = bit_reader.ByteCount();
         while (bit_reader.Get(cur_bit)) {
             if (!trie.Trace(cur_bit)) {
                 return throw ArchiveDamagedError("Can't decode content char code");
@@ -121,6 +89,9 @@ void Decompressor::Decompress() {
                     break;
                 }
                 ++file_size;
+                if (file_size % PROGRESS_STEP == 0) {
+                    Progress::Add(progress_file, PROGRESS_STEP);
+                }
                 bit_writer.Write(trie.TraceValue(), FILE_FIXED_CHAR_SIZE);
                 trie.ResetTrace();
             }
@@ -132,7 +103,16 @@ void Decompressor::Decompress() {
             return throw ArchiveDamagedError("Can't get information about next file or archive is end");
         }
 
+        decode_timer.Stop(stats_file, bit_reader.ByteCount() - content_start, file_size);
+        Progress::Add(progress_file, file_size % PROGRESS_STEP);
+        Progress::Finish(progress_file);
+        if (stats_ != nullptr) {
+            stats_->AddSizes(stats_file, file_size, bit_reader.ByteCount() - table_start);
+        }
+
+        StageTimer write_timer(stats_, Stage::WRITE);
         bit_writer.Complete();
+        write_timer.Stop(stats_file, 0, 0);
 
         // Save decompress file data to show information at finish
         files_.push_back(File(file_name, file_size));
@@ -143,21 +123,155 @@ void Decompressor::Decompress() {
     }
 }
 
-// Get files data
-std::vector<File> Decompressor::GetFiles() const {
-    return files_;
+// Writer of entries, that share blocks: decoded data of blocks is cut into files by positions of entries
+class GroupWriter {
+public:
+    GroupWriter(std::vector<IndexEntry> entries, std::vector<FileProgress*> progress, std::vector<File>& files)
+        : entries_(std::move(entries)), progress_(std::move(progress)), files_(files){};
+
+    void Write(const std::string& data);
+    void Finish();
+
+private:
+    std::vector<IndexEntry> entries_;      // Entries in order of their positions, that don't overlap
+    std::vector<FileProgress*> progress_;  // Counters of entries, which are null without progress
+    std::vector<File>& files_;
+    size_t current_ = 0;
+    uint64_t position_ = 0;  // Position in decoded data of blocks
+    std::ofstream output_;
+};
+
+void GroupWriter::Write(const std::string& data) {
+    size_t used = 0;
+    while (current_ < entries_.size()) {
+        const IndexEntry& entry = entries_[current_];
+        if (position_ < entry.skip) {
+            size_t skipped = std::min<uint64_t>(entry.skip - position_, data.size() - used);
+            used += skipped;
+            position_ += skipped;
+            if (position_ < entry.skip) {
+                return;
+            }
+        }
+
+        if (!output_.is_open()) {
+            output_.open(entry.name, std::ios::binary | std::ios::out);
+        }
+        size_t size = std::min<uint64_t>(entry.skip + entry.raw_size - position_, data.size() - used);
+        output_.write(data.data() + used, static_cast<std::streamsize>(size));
+        Progress::Add(progress_[current_], size);
+        used += size;
+        position_ += size;
+        if (position_ < entry.skip + entry.raw_size) {
+            return;
+        }
+
+        output_.close();
+        files_.push_back(File(entry.name, entry.raw_size));
+        ++current_;
+    }
 }
 
-// Exceptions
+// Write the rest of entries after all blocks
+void GroupWriter::Finish() {
+    Write("");
+    if (current_ < entries_.size()) {
+        throw Decompressor::ArchiveDamagedError("Entry size differs from index");
+    }
+}
+
+// Decompress indexed archive, every block of every entry is decoded by thread pool job, files are written in order.
+// Consecutive entries with the same blocks, like files of solid group, are decoded once
+void Decompressor::DecompressIndexed() {
+    ArchiveIndex index = ArchiveIndex::Read(archive_file_.GetPath());
+    std::ifstream archive(archive_file_.GetPath(), std::ios::binary | std::ios::in);
+
+    OrderedPipeline<std::string> pipeline(pool_);
+    const auto& entries = index.Entries();
+    size_t first_stats_file = 0;
+    for (size_t entry = 0; stats_ != nullptr && entry < entries.size(); ++entry) {
+        size_t stats_file = stats_->AddFile(entries[entry].name, entries[entry].raw_size);
+        if (entry == 0) {
+            first_stats_file = stats_file;
+        }
+    }
+    std::vector<FileProgress*> progress_files(entries.size());
+    for (size_t entry = 0; progress_ != nullptr && entry < entries.size(); ++entry) {
+        progress_files[entry] = progress_->AddFile(entries[entry].name, entries[entry].raw_size);
+    }
+
+    for (size_t first = 0; first < entries.size();) {
+        const IndexEntry& group_entry = entries[first];
+        size_t last = first + 1;
+        while (last < entries.size() && entries[last].offset == group_entry.offset &&
+               entries[last].size == group_entry.size &&
+               entries[last].skip >= entries[last - 1].skip + entries[last - 1].raw_size) {
+            ++last;
+        }
+        auto writer = std::make_shared<GroupWriter>(
+            std::vector<IndexEntry>(entries.begin() + static_cast<std::ptrdiff_t>(first),
+                                    entries.begin() + static_cast<std::ptrdiff_t>(last)),
+            std::vector<FileProgress*>(progress_files.begin() + static_cast<std::ptrdiff_t>(first),
+                                       progress_files.begin() + static_cast<std::ptrdiff_t>(last)),
+            files_);
+        // Stages of blocks shared by group are counted in its first file
+        size_t stats_file = first_stats_file + first;
+        first = last;
+
+        // Find blocks of group
+        uint64_t offset = group_entry.offset;
+        while (offset < group_entry.offset + group_entry.size) {
+            std::string header_data(BlockHeader::SIZE, '\0');
+            archive.seekg(static_cast<std::streamoff>(offset));
+            archive.read(header_data.data(), BlockHeader::SIZE);
+            if (archive.gcount() != static_cast<std::streamsize>(BlockHeader::SIZE)) {
+                throw ArchiveDamagedError("Can't read block header");
+            }
+            std::istringstream header_stream(header_data);
+            BitReader header_reader(header_stream);
+            BlockHeader header = BlockHeader::Read(header_reader);
+
+            uint64_t data_offset = offset + BlockHeader::SIZE;
+            offset = data_offset + header.size;
+            if (offset > group_entry.offset + group_entry.size) {
+                throw ArchiveDamagedError("Block is out of entry");
+            }
+            if (stats_ != nullptr) {
+                stats_->AddSizes(stats_file, 0, BlockHeader::SIZE + header.size);
+                stats_->AddCodec(stats_file, FindBlockCoder(header.codec).Name());
+            }
+
+            pipeline.Add(
+                {},
+                [path = archive_file_.GetPath(), header, data_offset, stats = stats_, stats_file] {
+                    StageTimer read_timer(stats, Stage::READ);
+                    std::ifstream stream(path, std::ios::binary | std::ios::in);
+                    std::string data(header.size, '\0');
+                    stream.seekg(static_cast<std::streamoff>(data_offset));
+                    stream.read(data.data(), header.size);
+                    if (stream.gcount() != static_cast<std::streamsize>(header.size)) {
+                        throw ArchiveDamagedError("Block is out of archive");
+                    }
+                    read_timer.Stop(stats_file, data.size(), data.size());
 
-// Constructor of ArchiveDamagedError
-Decompressor::ArchiveDamagedError::ArchiveDamagedError(const std::string& description) {
-    std::string full_description = "Archive is damaged, can't decompress it (" + description + ").";
-    description_ = new char[full_description.size()];
-    std::strcpy(description_, full_description.c_str());
+                    StageTimer decode_timer(stats, Stage::DECODE);
+                    std::string result = DecodeBlock(header, data);
+                    decode_timer.Stop(stats_file, data.size(), result.size());
+                    return result;
+                },
+                [writer, stats = stats_, stats_file](std::string& data) {
+                    StageTimer timer(stats, Stage::WRITE);
+                    writer->Write(data);
+                    timer.Stop(stats_file, data.size(), data.size());
+                });
+        }
+
+        pipeline.Add({}, [] { return std::string(); }, [writer](std::string&) { writer->Finish(); });
+    }
+    pipeline.Finish();
 }
 
-// Return more information about ArchiveDamagedError exception
-const char* Decompressor::ArchiveDamagedError::what() const noexcept {
-    return description_;
-}
\ No newline at end of file
+// Get files data
+std::vector<File> Decompressor::GetFiles() const {
+    return files_;
+}
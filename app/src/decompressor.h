@@ -5,6 +5,9 @@
 
 #include "service_symbols.h"
 #include "utils/file.h"
+#include "utils/progress.h"
+#include "utils/stats.h"
+#include "utils/thread_pool.h"
 
 class Decompressor {
 public:
@@ -18,13 +21,20 @@ public:
         char* description_;
     };
 
-    explicit Decompressor(std::string& archive_path) : archive_file_(File(archive_path)){};
+    Decompressor(std::string& archive_path, ThreadPool& pool, Stats* stats = nullptr, Progress* progress = nullptr)
+        : archive_file_(File(archive_path)), pool_(pool), stats_(stats), progress_(progress){};
 
     void Decompress();
 
     std::vector<File> GetFiles() const;
 
 private:
+    void DecompressStream();
+    void DecompressIndexed();
+
     std::vector<File> files_;
     const File archive_file_;
+    ThreadPool& pool_;
+    Stats* stats_;        // Stages are measured, if stats are given
+    Progress* progress_;  // Decoded bytes are counted, if progress is given
 };
@@ -0,0 +1,41 @@
+#include "encode_pipeline.h"
+
+// Complete bit_writer and take all its data as block
+EncodedBlock TakeBlock(StringBitWriter& bit_writer) {
+    EncodedBlock block;
+    block.bit_count = bit_writer.BitCount();
+    bit_writer.Complete();
+    block.bytes = bit_writer.Str();
+    return block;
+}
+
+// Encode chunk of file content into bit-packed block
+EncodedBlock EncodePipeline::Encode(const std::string& chunk, const CanonicalCodeGenerator<CharT>& canonical_code) {
+    StringBitWriter bit_writer;
+    for (char c : chunk) {
+        bit_writer.Write(canonical_code[static_cast<unsigned char>(c)]);
+    }
+    return TakeBlock(bit_writer);
+}
+
+// Add job, which block is written after blocks of all previous jobs, then commit is called for it. Writing is counted
+// in stats of given file
+void EncodePipeline::Add(size_t file, std::shared_future<void> dependency, Job job, Commit commit) {
+    pipeline_.Add(std::move(dependency), std::move(job), [this, file, commit = std::move(commit)](EncodedBlock& block) {
+        StageTimer timer(stats_, Stage::WRITE);
+        bit_writer_.Write(block.bytes, block.bit_count);
+        timer.Stop(file, block.bytes.size(), block.bytes.size());
+        if (stats_ != nullptr) {
+            stats_->AddSizes(file, 0, block.bytes.size());
+        }
+        if (commit) {
+            commit(block);
+        }
+    });
+}
+
+// Write all added blocks
+void EncodePipeline::Finish() {
+    pipeline_.Finish();
+    bit_writer_.Complete();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <string>
+
+#include "canonical_code.h"
+#include "service_symbols.h"
+#include "utils/bit_writer.h"
+#include "utils/ordered_pipeline.h"
+#include "utils/stats.h"
+#include "utils/thread_pool.h"
+
+// Bit-packed part of archive
+struct EncodedBlock {
+    std::string bytes;
+    size_t bit_count = 0;
+};
+
+EncodedBlock TakeBlock(StringBitWriter& bit_writer);
+
+// Commit stage of compression: blocks are encoded by thread pool jobs and appended to archive strictly in the order
+// they were added
+class EncodePipeline {
+public:
+    using Job = std::function<EncodedBlock()>;
+    using Commit = std::function<void(const EncodedBlock&)>;
+
+    static const size_t BLOCK_SIZE = 1 << 20;
+
+    EncodePipeline(ThreadPool& pool, BitWriter& bit_writer, Stats* stats = nullptr)
+        : pipeline_(pool), bit_writer_(bit_writer), stats_(stats){};
+
+    void Add(size_t file, std::shared_future<void> dependency, Job job, Commit commit = nullptr);
+    void Finish();
+
+    static EncodedBlock Encode(const std::string& chunk, const CanonicalCodeGenerator<CharT>& canonical_code);
+
+private:
+    OrderedPipeline<EncodedBlock> pipeline_;
+    BitWriter& bit_writer_;
+    Stats* stats_;
+};
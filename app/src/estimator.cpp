@@ -0,0 +1,236 @@
+#include "estimator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+
+#include "block_codec.h"
+#include "canonical_code.h"
+#include "service_symbols.h"
+#include "utils/bit_writer.h"
+#include "utils/counter.h"
+#include "utils/file.h"
+#include "utils/hash.h"
+
+// Sample of one stratum of file
+struct SampleResult {
+    uint64_t stratum_bytes = 0;
+    uint64_t bytes = 0;
+    std::vector<size_t> counts = std::vector<size_t>(1 << FILE_FIXED_CHAR_SIZE);
+    size_t data_bit_count = 0;   // Size of sample coded by its own Huffman code
+    size_t table_bit_count = 0;  // Size of compact table of the code
+    uint64_t bytes_ns = 0;       // Time of reading, counting and coding, that grows with size of data
+    uint64_t table_ns = 0;       // Time of building of the code, that is spent once per block
+};
+
+static std::string ReadSample(const std::string& path, uint64_t offset, uint64_t size) {
+    std::ifstream stream(path, std::ios::binary | std::ios::in);
+    if (stream.fail()) {
+        throw FileBitReader::FileNotExists(path);
+    }
+    std::string sample(size, 0);
+    stream.seekg(static_cast<std::streamoff>(offset));
+    stream.read(sample.data(), static_cast<std::streamsize>(size));
+    sample.resize(stream.gcount());
+    return sample;
+}
+
+// Read, count and encode sample like a block of indexed archive
+static SampleResult MeasureSample(const std::string& path, uint64_t offset, uint64_t size, uint64_t stratum_bytes) {
+    auto elapsed_ns = [](auto start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto start = std::chrono::steady_clock::now();
+    SampleResult result{.stratum_bytes = stratum_bytes};
+    std::string sample = ReadSample(path, offset, size);
+    result.bytes = sample.size();
+
+    Counter<CharT> counter;
+    for (char c : sample) {
+        counter.Add(static_cast<unsigned char>(c));
+    }
+    counter.Add(BLOCK_END);
+    result.bytes_ns = elapsed_ns(start);
+
+    start = std::chrono::steady_clock::now();
+    CanonicalCodeGenerator<CharT> code(counter);
+    result.table_ns = elapsed_ns(start);
+
+    start = std::chrono::steady_clock::now();
+    StringBitWriter bit_writer;
+    std::vector<size_t> code_sizes(BLOCK_END + 1);
+    for (const auto& [symbol, count] : counter) {
+        code_sizes[symbol] = code[symbol].Size();
+        if (symbol < static_cast<CharT>(result.counts.size())) {
+            result.counts[symbol] = count;
+        }
+    }
+    for (char c : sample) {
+        bit_writer.Write(code[static_cast<unsigned char>(c)]);
+    }
+    bit_writer.Write(code[BLOCK_END]);
+    result.data_bit_count = bit_writer.BitCount();
+    result.table_bit_count = CompactCodeTableBitCount(code_sizes);
+    result.bytes_ns += elapsed_ns(start);
+    return result;
+}
+
+// Size of file in stream format: one code of bytes of all samples, file name and service symbols, and full table
+static uint64_t StreamArchiveBytes(const FileEstimate& estimate, const std::vector<SampleResult>& samples) {
+    std::string name = File(estimate.path).GetName();
+    std::vector<size_t> counts(1 << FILE_FIXED_CHAR_SIZE);
+    for (const auto& sample : samples) {
+        for (size_t c = 0; c < counts.size(); ++c) {
+            counts[c] += sample.counts[c];
+        }
+    }
+
+    Counter<CharT> counter;
+    for (size_t c = 0; c < counts.size(); ++c) {
+        if (counts[c] > 0) {
+            counter.Add(static_cast<CharT>(c), counts[c]);
+        }
+    }
+    for (char c : name) {
+        counter.Add(static_cast<unsigned char>(c));
+    }
+    counter.Add(FILENAME_END);
+    counter.Add(ONE_MORE_FILE);
+    CanonicalCodeGenerator<CharT> code(counter);
+
+    long double scale = estimate.sampled_bytes > 0 ? static_cast<long double>(estimate.raw_bytes) /
+                                                         static_cast<long double>(estimate.sampled_bytes)
+                                                   : 0;
+    long double data_bit_count = 0;
+    for (size_t c = 0; c < counts.size(); ++c) {
+        data_bit_count += static_cast<long double>(counts[c] * code[static_cast<CharT>(c)].Size());
+    }
+    size_t name_bit_count = code[FILENAME_END].Size() + code[ONE_MORE_FILE].Size();
+    for (char c : name) {
+        name_bit_count += code[static_cast<unsigned char>(c)].Size();
+    }
+
+    StringBitWriter table_writer;
+    WriteCodeTable(table_writer, code);
+    return static_cast<uint64_t>((data_bit_count * scale + name_bit_count + table_writer.BitCount()) / 8);
+}
+
+// Size of file in indexed archive: every sample stands for blocks of its stratum, which are coded like the sample or
+// stored whole, if the code saves too little
+static uint64_t IndexedArchiveBytes(const FileEstimate& estimate, const std::vector<SampleResult>& samples,
+                                    size_t block_size) {
+    long double archive_bytes = static_cast<long double>(File(estimate.path).GetName().size());
+    for (const auto& sample : samples) {
+        if (sample.bytes == 0) {
+            continue;
+        }
+        uint64_t blocks_count = (sample.stratum_bytes + block_size - 1) / block_size;
+        long double bits_per_byte = static_cast<long double>(sample.data_bit_count) / sample.bytes;
+        long double coded = bits_per_byte * sample.stratum_bytes / 8 +
+                            static_cast<long double>(blocks_count * sample.table_bit_count) / 8;
+        // Like in encoder, blocks are stored as is, unless the code saves at least STORED_MIN_GAIN_PERCENT
+        long double stored = static_cast<long double>(sample.stratum_bytes);
+        bool is_coded = coded * 100 < stored * (100 - STORED_MIN_GAIN_PERCENT);
+        archive_bytes += (is_coded ? coded : stored) + blocks_count * BlockHeader::SIZE;
+    }
+    return static_cast<uint64_t>(archive_bytes);
+}
+
+// Files smaller than a sample aren't split, one of SAMPLED_PART of them is read whole, and the rest are expected to
+// have the same ratio and speed
+static void ExtrapolateSmallFiles(std::vector<FileEstimate>& estimates, const std::vector<bool>& sampled,
+                                  uint64_t sample_size) {
+    long double raw_bytes = 0;
+    long double archive_bytes = 0;
+    long double ns = 0;
+    for (size_t file = 0; file < estimates.size(); ++file) {
+        if (sampled[file] && estimates[file].raw_bytes < sample_size) {
+            raw_bytes += estimates[file].raw_bytes;
+            archive_bytes += estimates[file].archive_bytes;
+            ns += estimates[file].expected_ns;
+        }
+    }
+    for (size_t file = 0; file < estimates.size(); ++file) {
+        if (!sampled[file] && raw_bytes > 0) {
+            estimates[file].archive_bytes =
+                static_cast<uint64_t>(estimates[file].raw_bytes * archive_bytes / raw_bytes);
+            estimates[file].expected_ns = static_cast<uint64_t>(estimates[file].raw_bytes * ns / raw_bytes);
+        }
+    }
+}
+
+std::vector<FileEstimate> Estimator::Estimate() const {
+    size_t block_size = options_.NeedsIndex() ? options_.block_size : EncodePipeline::BLOCK_SIZE;
+    uint64_t sample_size = std::max<uint64_t>(block_size / SAMPLED_PART, 1);
+
+    // Samples of all files are measured at once
+    std::vector<FileEstimate> estimates;
+    std::vector<std::vector<std::future<SampleResult>>> samples(paths_.size());
+    std::vector<bool> sampled(paths_.size(), true);
+    size_t small_files_count = 0;
+    for (size_t file = 0; file < paths_.size(); ++file) {
+        const std::string& path = paths_[file];
+        if (!std::filesystem::exists(path)) {
+            throw FileBitReader::FileNotExists(path);
+        }
+        FileEstimate estimate{.path = path, .raw_bytes = std::filesystem::file_size(path)};
+        if (estimate.raw_bytes > 0 && estimate.raw_bytes < sample_size) {
+            sampled[file] = small_files_count++ % SAMPLED_PART == 0;
+        }
+        if (!sampled[file]) {
+            estimates.push_back(estimate);
+            continue;
+        }
+
+        uint64_t blocks_count = (estimate.raw_bytes + block_size - 1) / block_size;
+        uint64_t strata_count = std::min<uint64_t>(blocks_count, MAX_SAMPLES_COUNT);
+        uint64_t stratum_size = strata_count > 0 ? (blocks_count + strata_count - 1) / strata_count * block_size : 0;
+        for (uint64_t stratum_start = 0; stratum_start < estimate.raw_bytes; stratum_start += stratum_size) {
+            uint64_t stratum_bytes = std::min(stratum_size, estimate.raw_bytes - stratum_start);
+            uint64_t size = std::min(sample_size, stratum_bytes);
+            uint64_t offset = stratum_start + Hash(path, stratum_start) % (stratum_bytes - size + 1);
+            samples[file].push_back(pool_.Submit(
+                [path, offset, size, stratum_bytes] { return MeasureSample(path, offset, size, stratum_bytes); }));
+        }
+        estimates.push_back(estimate);
+    }
+
+    for (size_t file = 0; file < paths_.size(); ++file) {
+        if (!sampled[file]) {
+            continue;
+        }
+        FileEstimate& estimate = estimates[file];
+        std::vector<SampleResult> results;
+        for (auto& sample : samples[file]) {
+            results.push_back(sample.get());
+            estimate.sampled_bytes += results.back().bytes;
+        }
+        // Work with bytes is extrapolated by size, codes are built once per block or once per file in stream format
+        long double table_ns = 0;
+        for (const auto& sample : results) {
+            if (sample.bytes == 0) {
+                continue;
+            }
+            estimate.expected_ns +=
+                static_cast<uint64_t>(static_cast<long double>(sample.bytes_ns) * sample.stratum_bytes / sample.bytes);
+            table_ns += options_.NeedsIndex() ? static_cast<long double>(sample.table_ns) *
+                                                    ((sample.stratum_bytes + block_size - 1) / block_size)
+                                              : static_cast<long double>(sample.table_ns) / results.size();
+        }
+        estimate.expected_ns += static_cast<uint64_t>(table_ns);
+        estimate.archive_bytes = options_.NeedsIndex() ? IndexedArchiveBytes(estimate, results, block_size)
+                                                       : StreamArchiveBytes(estimate, results);
+    }
+    ExtrapolateSmallFiles(estimates, sampled, sample_size);
+    return estimates;
+}
+
+uint64_t Estimator::ExpectedMilliseconds(const std::vector<FileEstimate>& estimates, size_t threads_count) {
+    uint64_t ns = 0;
+    for (const auto& estimate : estimates) {
+        ns += estimate.expected_ns;
+    }
+    return ns / std::max<size_t>(threads_count, 1) / 1000000;
+}
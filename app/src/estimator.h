@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "compressor.h"
+#include "utils/thread_pool.h"
+
+// Estimate of one file in archive
+struct FileEstimate {
+    std::string path;
+    uint64_t raw_bytes = 0;
+    uint64_t sampled_bytes = 0;  // Bytes, that were read
+    uint64_t archive_bytes = 0;  // Expected size of file in archive
+    uint64_t expected_ns = 0;    // Expected time of compression of file in one thread
+};
+
+// Estimator predicts size of archive and time of compression by a sample of files. Every file is divided into strata
+// of equal size, one sample of block size / SAMPLED_PART bytes is read from a pseudo-random offset of every stratum,
+// so about 1 / SAMPLED_PART of data is read. Files smaller than a sample are read whole, but only every SAMPLED_PART-th
+// of them. Bytes of samples are counted by Counter, code sizes are given by CanonicalCodeGenerator, and sizes are
+// extrapolated: in stream format one code is built from all samples of file, in indexed archive every sample stands
+// for blocks of its stratum. Only Huffman code and stored blocks are modeled, other codecs may compress better
+class Estimator {
+public:
+    static constexpr size_t SAMPLED_PART = 32;
+    static constexpr size_t MAX_SAMPLES_COUNT = 64;  // Larger files have strata of several blocks
+
+    Estimator(const std::vector<std::string>& paths, ThreadPool& pool, const CompressionOptions& options)
+        : paths_(paths), pool_(pool), options_(options){};
+
+    std::vector<FileEstimate> Estimate() const;
+
+    // Expected wall time of compression of estimated files, if all threads are busy
+    static uint64_t ExpectedMilliseconds(const std::vector<FileEstimate>& estimates, size_t threads_count);
+
+private:
+    std::vector<std::string> paths_;
+    ThreadPool& pool_;
+    CompressionOptions options_;
+};
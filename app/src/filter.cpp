@@ -0,0 +1,76 @@
+#include "filter.h"
+
+#include <algorithm>
+
+#include "decompressor.h"
+
+size_t FilterStride(BlockFilter filter) {
+    switch (filter) {
+        case BlockFilter::NONE:
+            return 0;
+        case BlockFilter::DELTA:
+            return 1;
+        case BlockFilter::DELTA2:
+            return 2;
+        case BlockFilter::DELTA4:
+            return 4;
+        case BlockFilter::DELTA8:
+            return 8;
+    }
+    throw Decompressor::ArchiveDamagedError("Unknown block filter");
+}
+
+// Plain scalar loop over independent bytes, the first stride bytes are kept as is
+std::string ApplyFilter(const std::string& data, BlockFilter filter) {
+    size_t stride = FilterStride(filter);
+    if (stride == 0) {
+        return data;
+    }
+    std::string result(data.size(), '\0');
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data.data());
+    unsigned char* out = reinterpret_cast<unsigned char*>(result.data());
+    for (size_t i = 0; i < std::min(stride, data.size()); ++i) {
+        out[i] = in[i];
+    }
+    for (size_t i = stride; i < data.size(); ++i) {
+        out[i] = static_cast<unsigned char>(in[i] - in[i - stride]);
+    }
+    return result;
+}
+
+// Every byte depends on the byte stride bytes before, so there are stride independent sums
+void RevertFilter(std::string& data, BlockFilter filter) {
+    size_t stride = FilterStride(filter);
+    if (stride == 0) {
+        return;
+    }
+    unsigned char* out = reinterpret_cast<unsigned char*>(data.data());
+    for (size_t i = stride; i < data.size(); ++i) {
+        out[i] = static_cast<unsigned char>(out[i] + out[i - stride]);
+    }
+}
+
+std::vector<std::string> SplitLanes(const std::string& data, size_t lanes_count) {
+    std::vector<std::string> lanes(lanes_count);
+    for (size_t lane = 0; lane < lanes_count; ++lane) {
+        lanes[lane].resize((data.size() + lanes_count - 1 - lane) / lanes_count);
+        for (size_t i = 0; i < lanes[lane].size(); ++i) {
+            lanes[lane][i] = data[i * lanes_count + lane];
+        }
+    }
+    return lanes;
+}
+
+std::string MergeLanes(const std::vector<std::string>& lanes) {
+    size_t size = 0;
+    for (const auto& lane : lanes) {
+        size += lane.size();
+    }
+    std::string data(size, '\0');
+    for (size_t lane = 0; lane < lanes.size(); ++lane) {
+        for (size_t i = 0; i < lanes[lane].size(); ++i) {
+            data[i * lanes.size() + lane] = lanes[lane][i];
+        }
+    }
+    return data;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reversible filters, that are applied to data of block before its code. Numeric data often changes slowly, so
+// differences of bytes have less entropy than bytes themselves
+enum class BlockFilter : uint8_t {
+    NONE = 0,
+    DELTA = 1,   // Difference with the previous byte
+    DELTA2 = 2,  // Difference with byte of the previous 2-byte record
+    DELTA4 = 3,  // Difference with byte of the previous 4-byte record
+    DELTA8 = 4,  // Difference with byte of the previous 8-byte record
+};
+static constexpr size_t BLOCK_FILTERS_COUNT = 5;
+
+// Distance to the byte, that filter subtracts, zero for no filter
+size_t FilterStride(BlockFilter filter);
+
+std::string ApplyFilter(const std::string& data, BlockFilter filter);
+void RevertFilter(std::string& data, BlockFilter filter);
+
+// Byte lanes of records of lanes_count bytes: the i-th lane has every i-th byte of every record. Last record may be
+// incomplete, so the first lanes may be one byte longer
+std::vector<std::string> SplitLanes(const std::string& data, size_t lanes_count);
+std::string MergeLanes(const std::vector<std::string>& lanes);
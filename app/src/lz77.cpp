@@ -0,0 +1,148 @@
+#include "lz77.h"
+
+#include <algorithm>
+#include <limits>
+
+static constexpr size_t HASH_BITS = 15;
+static constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+
+// Matches of minimal length, that are further, cost more than literals
+static constexpr size_t MIN_MATCH_MAX_DISTANCE = 4096;
+
+// Chains of previous positions with the same hash of the next LZ77_MIN_MATCH bytes
+class HashChains {
+public:
+    HashChains(const std::string& data, const Lz77Options& options)
+        : data_(data),
+          window_(static_cast<size_t>(1) << options.window_bits),
+          effort_(std::max<size_t>(options.effort, 1)),
+          head_(static_cast<size_t>(1) << HASH_BITS, NO_POSITION),
+          previous_(data.size(), NO_POSITION){};
+
+    void Insert(size_t position);
+    void FindLongest(size_t position, size_t& length, size_t& distance) const;
+
+private:
+    size_t Hash(size_t position) const;
+
+    const std::string& data_;
+    const size_t window_;
+    const size_t effort_;
+    std::vector<uint32_t> head_;
+    std::vector<uint32_t> previous_;
+};
+
+size_t HashChains::Hash(size_t position) const {
+    uint32_t value = static_cast<uint32_t>(static_cast<unsigned char>(data_[position])) << 16 |
+                     static_cast<uint32_t>(static_cast<unsigned char>(data_[position + 1])) << 8 |
+                     static_cast<uint32_t>(static_cast<unsigned char>(data_[position + 2]));
+    return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+void HashChains::Insert(size_t position) {
+    if (position + LZ77_MIN_MATCH > data_.size()) {
+        return;
+    }
+    size_t hash = Hash(position);
+    previous_[position] = head_[hash];
+    head_[hash] = static_cast<uint32_t>(position);
+}
+
+// Find the longest match of data at position among no more than effort previous positions with the same hash
+void HashChains::FindLongest(size_t position, size_t& length, size_t& distance) const {
+    length = 0;
+    distance = 0;
+    if (position + LZ77_MIN_MATCH > data_.size()) {
+        return;
+    }
+
+    size_t max_length = std::min(LZ77_MAX_MATCH, data_.size() - position);
+    uint32_t candidate = head_[Hash(position)];
+    for (size_t step = 0; step < effort_ && candidate != NO_POSITION && position - candidate <= window_; ++step) {
+        if (data_[candidate + length] == data_[position + length]) {
+            size_t candidate_length = 0;
+            while (candidate_length < max_length &&
+                   data_[candidate + candidate_length] == data_[position + candidate_length]) {
+                ++candidate_length;
+            }
+            if (candidate_length > length) {
+                length = candidate_length;
+                distance = position - candidate;
+                if (length == max_length) {
+                    break;
+                }
+            }
+        }
+        candidate = previous_[candidate];
+    }
+
+    if (length < LZ77_MIN_MATCH || (length == LZ77_MIN_MATCH && distance > MIN_MATCH_MAX_DISTANCE)) {
+        length = 0;
+        distance = 0;
+    }
+}
+
+// Split data into literals and matches. Matching is lazy: match is postponed for one byte, if the next byte starts
+// a longer match
+std::vector<Lz77Token> FindMatches(const std::string& data, const Lz77Options& options) {
+    HashChains chains(data, options);
+    std::vector<Lz77Token> tokens;
+
+    size_t position = 0;
+    size_t length = 0;
+    size_t distance = 0;
+    chains.FindLongest(position, length, distance);
+    while (position < data.size()) {
+        chains.Insert(position);
+
+        size_t next_length = 0;
+        size_t next_distance = 0;
+        if (length > 0 && position + 1 < data.size()) {
+            chains.FindLongest(position + 1, next_length, next_distance);
+        }
+
+        if (length == 0 || next_length > length) {
+            tokens.push_back({.length = 0, .distance = static_cast<unsigned char>(data[position])});
+            ++position;
+            if (length == 0) {
+                chains.FindLongest(position, length, distance);
+            } else {
+                length = next_length;
+                distance = next_distance;
+            }
+            continue;
+        }
+
+        tokens.push_back({.length = static_cast<uint32_t>(length), .distance = static_cast<uint32_t>(distance)});
+        for (size_t i = 1; i < length; ++i) {
+            chains.Insert(position + i);
+        }
+        position += length;
+        chains.FindLongest(position, length, distance);
+    }
+    return tokens;
+}
+
+// Get code of bucket of value, position of value in the bucket and count of bits of the position
+void BucketCode(uint32_t value, uint32_t& code, uint32_t& extra, size_t& extra_bit_count) {
+    if (value < 4) {
+        code = value;
+        extra = 0;
+        extra_bit_count = 0;
+        return;
+    }
+    size_t high_bit = 31 - __builtin_clz(value);
+    extra_bit_count = high_bit - 1;
+    code = static_cast<uint32_t>(2 * high_bit) + ((value >> extra_bit_count) & 1);
+    extra = value & ((static_cast<uint32_t>(1) << extra_bit_count) - 1);
+}
+
+// Get the first value of bucket and count of bits of position in it
+uint32_t BucketBase(uint32_t code, size_t& extra_bit_count) {
+    if (code < 4) {
+        extra_bit_count = 0;
+        return code;
+    }
+    extra_bit_count = code / 2 - 1;
+    return (2 | (code & 1)) << extra_bit_count;
+}
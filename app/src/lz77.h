@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "service_symbols.h"
+
+// Literal of data or match with previous data
+struct Lz77Token {
+    uint32_t length = 0;    // Length of match, zero for literal
+    uint32_t distance = 0;  // Distance back to the start of match, literal byte for literal
+};
+
+// Settings of match finder
+struct Lz77Options {
+    static constexpr size_t MIN_WINDOW_BITS = 10;
+    static constexpr size_t MAX_WINDOW_BITS = 20;
+    static constexpr size_t MAX_EFFORT = 1 << 16;
+
+    size_t window_bits = 16;  // Matches are searched no further than 2^window_bits bytes back
+    size_t effort = 32;       // Count of previous positions checked for every match
+};
+
+static constexpr size_t LZ77_MIN_MATCH = 3;
+static constexpr size_t LZ77_MAX_MATCH = 258;
+
+// Lengths and distances are coded by buckets: values below 4 have own codes, then every power of two is split into
+// two codes, and position in the bucket is written by extra bits
+static constexpr size_t LZ77_LENGTH_CODES = 16;
+static constexpr size_t LZ77_DISTANCE_CODES = 2 * Lz77Options::MAX_WINDOW_BITS;
+
+// Lengths codes are symbols of literals code after BLOCK_END
+static const CharT LZ77_LENGTH_BASE = BLOCK_END + 1;
+
+std::vector<Lz77Token> FindMatches(const std::string& data, const Lz77Options& options);
+
+void BucketCode(uint32_t value, uint32_t& code, uint32_t& extra, size_t& extra_bit_count);
+uint32_t BucketBase(uint32_t code, size_t& extra_bit_count);
@@ -0,0 +1,120 @@
+#include "report.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+static constexpr double MEGABYTE = 1 << 20;
+
+// String in quotes with JSON escapes
+static std::string JsonString(const std::string& s) {
+    std::ostringstream result;
+    result << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            result << c;
+        }
+    }
+    result << '"';
+    return result.str();
+}
+
+static double Ratio(uint64_t archive_bytes, uint64_t raw_bytes) {
+    return raw_bytes > 0 ? static_cast<double>(archive_bytes) / static_cast<double>(raw_bytes) : 0;
+}
+
+static double Throughput(uint64_t raw_bytes, double milliseconds) {
+    return milliseconds > 0 ? static_cast<double>(raw_bytes) / MEGABYTE / (milliseconds / 1000) : 0;
+}
+
+static void WriteStages(std::ostream& stream, const std::array<StageTotals, STAGES_COUNT>& stages) {
+    stream << "{";
+    for (size_t stage = 0; stage < STAGES_COUNT; ++stage) {
+        const StageTotals& totals = stages[stage];
+        stream << (stage > 0 ? ", " : "") << JsonString(std::string(StageName(static_cast<Stage>(stage))))
+               << ": {\"wall_ms\": " << static_cast<double>(totals.wall_ns) / 1e6
+               << ", \"cpu_ms\": " << static_cast<double>(totals.cpu_ns) / 1e6 << ", \"bytes_in\": " << totals.bytes_in
+               << ", \"bytes_out\": " << totals.bytes_out << ", \"cycles\": " << totals.counters.cycles
+               << ", \"instructions\": " << totals.counters.instructions
+               << ", \"branch_misses\": " << totals.counters.branch_misses
+               << ", \"cache_misses\": " << totals.counters.cache_misses << ", \"allocations\": " << totals.allocations
+               << ", \"allocated_bytes\": " << totals.allocated_bytes
+               << ", \"peak_live_bytes\": " << totals.peak_live_bytes << "}";
+    }
+    stream << "}";
+}
+
+static void WriteCodecs(std::ostream& stream, const std::map<std::string, size_t>& codecs) {
+    stream << "{";
+    bool first = true;
+    for (const auto& [codec, count] : codecs) {
+        stream << (first ? "" : ", ") << JsonString(codec) << ": " << count;
+        first = false;
+    }
+    stream << "}";
+}
+
+void WriteJsonReport(const std::string& path, const RunReport& report, const Stats& stats) {
+    std::vector<FileStats> files = stats.Files();
+    uint64_t raw_bytes = 0;
+    uint64_t archive_bytes = 0;
+    std::map<std::string, size_t> codecs;
+    for (const auto& file : files) {
+        raw_bytes += file.raw_bytes;
+        archive_bytes += file.archive_bytes;
+        for (const auto& [codec, count] : file.codecs) {
+            codecs[codec] += count;
+        }
+    }
+
+    std::ofstream stream(path);
+    if (stream.fail()) {
+        throw std::runtime_error("Can't write report \"" + path + "\".");
+    }
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\n";
+    stream << "  \"mode\": " << JsonString(report.mode) << ",\n";
+    stream << "  \"archive\": " << JsonString(report.archive_path) << ",\n";
+    stream << "  \"indexed\": " << (report.indexed ? "true" : "false") << ",\n";
+    stream << "  \"threads\": " << report.threads_count << ",\n";
+    stream << "  \"archive_file_bytes\": " << std::filesystem::file_size(report.archive_path) << ",\n";
+    stream << "  \"raw_bytes\": " << raw_bytes << ",\n";
+    stream << "  \"archive_bytes\": " << archive_bytes << ",\n";
+    stream << "  \"ratio\": " << Ratio(archive_bytes, raw_bytes) << ",\n";
+    stream << "  \"duration_ms\": " << report.duration_ms << ",\n";
+    stream << "  \"throughput_mb_per_s\": " << Throughput(raw_bytes, static_cast<double>(report.duration_ms))
+           << ",\n";
+    stream << "  \"peak_memory_bytes\": " << PeakMemory() << ",\n";
+    stream << "  \"allocations_counted\": " << (AllocationCounter::Enabled() ? "true" : "false") << ",\n";
+    stream << "  \"peak_live_bytes\": " << AllocationCounter::ProcessPeakLiveBytes() << ",\n";
+    stream << "  \"stages\": ";
+    WriteStages(stream, stats.Total());
+    stream << ",\n  \"codecs\": ";
+    WriteCodecs(stream, codecs);
+    stream << ",\n  \"files\": [";
+    for (size_t file_index = 0; file_index < files.size(); ++file_index) {
+        const FileStats& file = files[file_index];
+        uint64_t cpu_ns = 0;
+        for (const auto& totals : file.stages) {
+            cpu_ns += totals.cpu_ns;
+        }
+        stream << (file_index > 0 ? "," : "") << "\n    {\"name\": " << JsonString(file.name)
+               << ", \"raw_bytes\": " << file.raw_bytes << ", \"archive_bytes\": " << file.archive_bytes
+               << ", \"ratio\": " << Ratio(file.archive_bytes, file.raw_bytes)
+               << ", \"cpu_ms\": " << static_cast<double>(cpu_ns) / 1e6
+               << ", \"cpu_mb_per_s\": " << Throughput(file.raw_bytes, static_cast<double>(cpu_ns) / 1e6)
+               << ",\n     \"stages\": ";
+        WriteStages(stream, file.stages);
+        stream << ",\n     \"codecs\": ";
+        WriteCodecs(stream, file.codecs);
+        stream << "}";
+    }
+    stream << (files.empty() ? "" : "\n  ") << "]\n}\n";
+}
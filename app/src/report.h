@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "utils/stats.h"
+
+// Run of archiver, that --report-json describes together with stats of its files
+struct RunReport {
+    std::string mode;  // "compress", "append" or "decompress"
+    std::string archive_path;
+    bool indexed = false;
+    size_t threads_count = 0;
+    uint64_t duration_ms = 0;
+};
+
+// Write report as JSON object: settings of run, sizes, ratio, throughput, peak memory of the process, stages and
+// codecs of blocks in total and per file. Throughput of file is its size per CPU time of its stages, because files
+// are processed in parallel
+void WriteJsonReport(const std::string& path, const RunReport& report, const Stats& stats);
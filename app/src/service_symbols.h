@@ -9,6 +9,9 @@ static const CharT FILENAME_END = 0b100000000;
 static const CharT ONE_MORE_FILE = 0b100000001;
 static const CharT ARCHIVE_END = 0b100000010;
 
+// Blocks of indexed archives end with the same symbol as archive
+static const CharT BLOCK_END = ARCHIVE_END;
+
 static const CharT MAX_CHAR_VALUE = 258;
 
 // Archive format fixed char size for compressing and decompressing
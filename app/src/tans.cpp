@@ -0,0 +1,219 @@
+#include "tans.h"
+
+#include <cmath>
+
+#include "decompressor.h"
+#include "utils/bit_window.h"
+
+static constexpr size_t TABLE_LOG_BIT_COUNT = 4;
+
+static size_t HighBit(uint32_t value) {
+    return 31 - __builtin_clz(value);
+}
+
+TansCounts NormalizeCounts(const std::array<size_t, TANS_SYMBOLS_COUNT>& data_counts) {
+    TansCounts result;
+    size_t total = 0;
+    size_t symbols_count = 0;
+    for (size_t count : data_counts) {
+        total += count;
+        symbols_count += count > 0;
+    }
+    if (total == 0) {
+        return result;
+    }
+
+    // Table, that is much larger than data, only makes its header longer
+    result.table_log = TANS_MAX_TABLE_LOG;
+    while (result.table_log > TANS_MIN_TABLE_LOG && (static_cast<size_t>(1) << (result.table_log - 1)) >= total) {
+        --result.table_log;
+    }
+    while ((static_cast<size_t>(1) << result.table_log) < 2 * symbols_count) {
+        ++result.table_log;
+    }
+    size_t table_size = static_cast<size_t>(1) << result.table_log;
+
+    size_t sum = 0;
+    for (size_t c = 0; c < TANS_SYMBOLS_COUNT; ++c) {
+        if (data_counts[c] > 0) {
+            result.counts[c] = static_cast<uint32_t>(std::max<size_t>(data_counts[c] * table_size / total, 1));
+            sum += result.counts[c];
+        }
+    }
+
+    // Rounding is fixed by one state at a time, where it costs the least bits of data
+    while (sum != table_size) {
+        size_t best = TANS_SYMBOLS_COUNT;
+        double best_cost = 0;
+        for (size_t c = 0; c < TANS_SYMBOLS_COUNT; ++c) {
+            uint32_t count = result.counts[c];
+            if (count == 0 || (sum > table_size && count == 1)) {
+                continue;
+            }
+            double cost = sum < table_size ? -std::log2(static_cast<double>(count + 1) / count)
+                                           : std::log2(static_cast<double>(count) / (count - 1));
+            cost *= static_cast<double>(data_counts[c]);
+            if (best == TANS_SYMBOLS_COUNT || cost < best_cost) {
+                best = c;
+                best_cost = cost;
+            }
+        }
+        if (sum < table_size) {
+            ++result.counts[best];
+            ++sum;
+        } else {
+            --result.counts[best];
+            --sum;
+        }
+    }
+    return result;
+}
+
+size_t TansCounts::EstimateBitCount(const std::array<size_t, TANS_SYMBOLS_COUNT>& data_counts) const {
+    double bit_count = 0;
+    for (size_t c = 0; c < TANS_SYMBOLS_COUNT; ++c) {
+        if (data_counts[c] > 0) {
+            bit_count += static_cast<double>(data_counts[c]) *
+                         (static_cast<double>(table_log) - std::log2(static_cast<double>(counts[c])));
+        }
+    }
+    return static_cast<size_t>(std::ceil(bit_count)) + BitCount() + table_log;
+}
+
+// Size of table log, flags of present bytes and their counts minus one
+size_t TansCounts::BitCount() const {
+    size_t bit_count = TABLE_LOG_BIT_COUNT + TANS_SYMBOLS_COUNT;
+    for (uint32_t count : counts) {
+        bit_count += count > 0 ? table_log : 0;
+    }
+    return bit_count;
+}
+
+void TansCounts::Write(BitWriter& bit_writer) const {
+    bit_writer.Write(table_log, TABLE_LOG_BIT_COUNT);
+    for (uint32_t count : counts) {
+        bit_writer.Write(count > 0);
+        if (count > 0) {
+            bit_writer.Write(count - 1, table_log);
+        }
+    }
+}
+
+TansCounts TansCounts::Read(BitReader& bit_reader) {
+    TansCounts result;
+    if (!bit_reader.Get(result.table_log, TABLE_LOG_BIT_COUNT) || result.table_log < TANS_MIN_TABLE_LOG ||
+        result.table_log > TANS_MAX_TABLE_LOG) {
+        throw Decompressor::ArchiveDamagedError("Can't read tANS table of block");
+    }
+
+    size_t sum = 0;
+    for (uint32_t& count : result.counts) {
+        bool present = false;
+        if (!bit_reader.Get(present) || (present && !bit_reader.Get(count, result.table_log))) {
+            throw Decompressor::ArchiveDamagedError("Can't read tANS table of block");
+        }
+        count += present;
+        sum += count;
+    }
+    if (sum != static_cast<size_t>(1) << result.table_log) {
+        throw Decompressor::ArchiveDamagedError("Wrong counts of tANS table of block");
+    }
+    return result;
+}
+
+// Symbols of states: states of every symbol are spread over the table, so that symbol takes its part of any range of
+// states. Odd step visits every state of table once
+static std::vector<uint8_t> SpreadSymbols(const TansCounts& counts) {
+    size_t table_size = static_cast<size_t>(1) << counts.table_log;
+    size_t step = (table_size >> 1) + (table_size >> 3) + 3;
+    std::vector<uint8_t> symbols(table_size);
+    size_t position = 0;
+    for (size_t c = 0; c < TANS_SYMBOLS_COUNT; ++c) {
+        for (uint32_t i = 0; i < counts.counts[c]; ++i) {
+            symbols[position] = static_cast<uint8_t>(c);
+            position = (position + step) & (table_size - 1);
+        }
+    }
+    return symbols;
+}
+
+TansEncoder::TansEncoder(const TansCounts& counts)
+    : table_log_(counts.table_log), states_(static_cast<size_t>(1) << counts.table_log) {
+    uint32_t table_size = static_cast<uint32_t>(states_.size());
+
+    std::array<uint32_t, TANS_SYMBOLS_COUNT> next = {};
+    uint32_t start = 0;
+    for (size_t c = 0; c < TANS_SYMBOLS_COUNT; ++c) {
+        uint32_t count = counts.counts[c];
+        next[c] = start;
+        if (count == 1) {
+            transforms_[c].delta_bit_count = (static_cast<uint32_t>(table_log_) << 16) - table_size;
+        } else if (count > 1) {
+            uint32_t max_bit_count = static_cast<uint32_t>(table_log_ - HighBit(count - 1));
+            transforms_[c].delta_bit_count = (max_bit_count << 16) - (count << max_bit_count);
+        }
+        transforms_[c].delta_state = static_cast<int32_t>(start) - static_cast<int32_t>(count);
+        start += count;
+    }
+
+    std::vector<uint8_t> symbols = SpreadSymbols(counts);
+    for (uint32_t position = 0; position < table_size; ++position) {
+        states_[next[symbols[position]]++] = static_cast<uint16_t>(table_size + position);
+    }
+}
+
+void TansEncoder::Encode(const std::string& data, BitWriter& bit_writer) const {
+    uint32_t table_size = static_cast<uint32_t>(states_.size());
+
+    // Bits of every byte with their count in the lowest 4 bits, in reverse order
+    std::vector<uint16_t> chunks;
+    chunks.reserve(data.size());
+    uint32_t state = table_size;
+    for (size_t i = data.size(); i-- > 0;) {
+        const SymbolTransform& transform = transforms_[static_cast<unsigned char>(data[i])];
+        uint32_t bit_count = (state + transform.delta_bit_count) >> 16;
+        chunks.push_back(static_cast<uint16_t>((state & ((1U << bit_count) - 1)) << 4 | bit_count));
+        state = states_[static_cast<int32_t>(state >> bit_count) + transform.delta_state];
+    }
+
+    bit_writer.Write(state - table_size, table_log_);
+    for (size_t i = chunks.size(); i-- > 0;) {
+        bit_writer.Write(chunks[i] >> 4, chunks[i] & 0xF);
+    }
+}
+
+TansDecoder::TansDecoder(const TansCounts& counts)
+    : table_log_(counts.table_log), entries_(static_cast<size_t>(1) << counts.table_log) {
+    uint32_t table_size = static_cast<uint32_t>(entries_.size());
+
+    std::array<uint32_t, TANS_SYMBOLS_COUNT> next = counts.counts;
+    std::vector<uint8_t> symbols = SpreadSymbols(counts);
+    for (uint32_t position = 0; position < table_size; ++position) {
+        uint8_t symbol = symbols[position];
+        uint32_t state = next[symbol]++;
+        uint32_t bit_count = static_cast<uint32_t>(table_log_ - HighBit(state));
+        entries_[position] = {.base = static_cast<uint16_t>((state << bit_count) - table_size),
+                              .symbol = symbol,
+                              .bit_count = static_cast<uint8_t>(bit_count)};
+    }
+}
+
+// Decode size bytes starting from bit_position. Encoder starts from the first state, so decoder must end there
+std::string TansDecoder::Decode(const std::string& data, size_t bit_position, size_t size) const {
+    BitWindow window(data, bit_position);
+    uint32_t state = static_cast<uint32_t>(window.Peek() >> (64 - table_log_));
+    window.Skip(table_log_);
+
+    std::string result(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        const Entry& entry = entries_[state];
+        result[i] = static_cast<char>(entry.symbol);
+        state = entry.base + static_cast<uint32_t>((window.Peek() >> (63 - entry.bit_count)) >> 1);
+        window.Skip(entry.bit_count);
+    }
+
+    if (window.Overrun() || state != 0) {
+        throw Decompressor::ArchiveDamagedError("Block data is damaged");
+    }
+    return result;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/bit_reader.h"
+#include "utils/bit_writer.h"
+
+// Sizes of table of tANS code are powers of two, small blocks get smaller tables
+static constexpr size_t TANS_MIN_TABLE_LOG = 5;
+static constexpr size_t TANS_MAX_TABLE_LOG = 12;
+
+static constexpr size_t TANS_SYMBOLS_COUNT = 256;
+
+// Counts of bytes normalized so that they sum to the size of the table, every present byte gets at least one state
+struct TansCounts {
+    size_t table_log = TANS_MIN_TABLE_LOG;
+    std::array<uint32_t, TANS_SYMBOLS_COUNT> counts = {};
+
+    // Size of data in bits, when its bytes have given counts
+    size_t EstimateBitCount(const std::array<size_t, TANS_SYMBOLS_COUNT>& data_counts) const;
+    size_t BitCount() const;
+
+    void Write(BitWriter& bit_writer) const;
+    static TansCounts Read(BitReader& bit_reader);
+};
+
+TansCounts NormalizeCounts(const std::array<size_t, TANS_SYMBOLS_COUNT>& data_counts);
+
+// Table-driven tANS coder. Encoder goes from the last byte to the first one, so decoder reads bits forward
+class TansEncoder {
+public:
+    explicit TansEncoder(const TansCounts& counts);
+
+    // Final state of encoder, then bits of every byte
+    void Encode(const std::string& data, BitWriter& bit_writer) const;
+
+private:
+    struct SymbolTransform {
+        uint32_t delta_bit_count;  // Bit count of state is (state + delta_bit_count) >> 16
+        int32_t delta_state;       // Position of the first state of symbol in states_ minus its count
+    };
+
+    size_t table_log_;
+    std::array<SymbolTransform, TANS_SYMBOLS_COUNT> transforms_ = {};
+    std::vector<uint16_t> states_;  // States of every symbol in order of symbols
+};
+
+class TansDecoder {
+public:
+    explicit TansDecoder(const TansCounts& counts);
+
+    std::string Decode(const std::string& data, size_t bit_position, size_t size) const;
+
+private:
+    struct Entry {
+        uint16_t base;  // State after reading bits is base plus bits
+        uint8_t symbol;
+        uint8_t bit_count;
+    };
+
+    size_t table_log_;
+    std::vector<Entry> entries_;
+};
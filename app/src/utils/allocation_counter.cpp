@@ -0,0 +1,142 @@
+#include "allocation_counter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_ALLOCATIONS
+#include <malloc.h>
+#endif
+
+AllocationValues AllocationValues::operator-(const AllocationValues& other) const {
+    return {.allocations = allocations - other.allocations,
+            .bytes = bytes - other.bytes,
+            .live_bytes = live_bytes - other.live_bytes,
+            .peak_live_bytes = peak_live_bytes - other.live_bytes};
+}
+
+#ifdef COUNT_ALLOCATIONS
+
+// Values are plain data without constructors, so that they may be touched by the first allocation of a thread
+static thread_local AllocationValues thread_values;
+static std::atomic<uint64_t> process_live_bytes = 0;
+static std::atomic<uint64_t> process_peak_live_bytes = 0;
+
+static void* CountAllocation(void* pointer) {
+    if (pointer == nullptr) {
+        return nullptr;
+    }
+    uint64_t size = malloc_usable_size(pointer);
+    ++thread_values.allocations;
+    thread_values.bytes += size;
+    thread_values.live_bytes += static_cast<int64_t>(size);
+    thread_values.peak_live_bytes = std::max(thread_values.peak_live_bytes, thread_values.live_bytes);
+    uint64_t live = process_live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = process_peak_live_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !process_peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return pointer;
+}
+
+static void CountFree(void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    uint64_t size = malloc_usable_size(pointer);
+    thread_values.live_bytes -= static_cast<int64_t>(size);
+    process_live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    free(pointer);
+}
+
+bool AllocationCounter::Enabled() {
+    return true;
+}
+
+AllocationValues AllocationCounter::Read() {
+    return thread_values;
+}
+
+int64_t AllocationCounter::ResetPeak() {
+    int64_t previous_peak = thread_values.peak_live_bytes;
+    thread_values.peak_live_bytes = thread_values.live_bytes;
+    return previous_peak;
+}
+
+void AllocationCounter::RestorePeak(int64_t previous_peak) {
+    thread_values.peak_live_bytes = std::max(thread_values.peak_live_bytes, previous_peak);
+}
+
+uint64_t AllocationCounter::ProcessPeakLiveBytes() {
+    return process_peak_live_bytes.load(std::memory_order_relaxed);
+}
+
+// Replacements of global allocation functions. Aligned versions aren't replaced: they allocate and free by their own
+// functions of the standard library and are just not counted
+
+void* operator new(size_t size) {
+    void* pointer = CountAllocation(malloc(std::max<size_t>(size, 1)));
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return CountAllocation(malloc(std::max<size_t>(size, 1)));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return CountAllocation(malloc(std::max<size_t>(size, 1)));
+}
+
+void operator delete(void* pointer) noexcept {
+    CountFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    CountFree(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    CountFree(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    CountFree(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    CountFree(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    CountFree(pointer);
+}
+
+#else
+
+bool AllocationCounter::Enabled() {
+    return false;
+}
+
+AllocationValues AllocationCounter::Read() {
+    return {};
+}
+
+int64_t AllocationCounter::ResetPeak() {
+    return 0;
+}
+
+void AllocationCounter::RestorePeak(int64_t) {
+}
+
+uint64_t AllocationCounter::ProcessPeakLiveBytes() {
+    return 0;
+}
+
+#endif
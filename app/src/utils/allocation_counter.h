@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// Allocations made by one thread
+struct AllocationValues {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    int64_t live_bytes = 0;  // Bytes allocated minus bytes freed by this thread, negative if it frees memory of others
+    int64_t peak_live_bytes = 0;
+
+    // Peak of difference is peak above live bytes of other
+    AllocationValues operator-(const AllocationValues& other) const;
+};
+
+// Global operator new and delete are replaced, if the archiver is built with ARCHIVER_COUNT_ALLOCATIONS option, and
+// count allocations of every thread and live memory of the process. Sizes are usable sizes of malloc, so memory, that
+// is freed by another thread, is subtracted correctly. Otherwise nothing is counted and values are zero
+class AllocationCounter {
+public:
+    static bool Enabled();
+
+    static AllocationValues Read();
+
+    // Start peak of live bytes of this thread from the current live bytes, so that peak of one job is measured, and
+    // return the previous peak. Restore keeps the larger of both peaks, so measured jobs may be nested
+    static int64_t ResetPeak();
+    static void RestorePeak(int64_t previous_peak);
+
+    // Peak of bytes allocated by new and not yet freed in the whole process
+    static uint64_t ProcessPeakLiveBytes();
+};
@@ -9,7 +9,7 @@ bool BitReader::Update() {
         char_pointer_ = READER_CHAR_START_POINTER;
         ++byte_count_;
     }
-    if (index_ >= buffer_size_) {
+    if (index_ >= static_cast<std::streamsize>(buffer_size_)) {
         if (stream_.eof()) {
             return false;
         }
@@ -71,6 +71,7 @@ void BitReader::Reset() {
     stream_.clear();
     stream_.seekg(0);
     buffer_size_ = 0;
+    char_pointer_ = READER_CHAR_START_POINTER;
     index_ = 0;
     byte_count_ = 0;
 }
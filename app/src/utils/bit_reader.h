@@ -14,7 +14,8 @@ protected:
     using BufferT = char;
 
 public:
-    explicit BitReader(std::istream& stream) : stream_(stream), buffer_size_(0), index_(0), byte_count_(0){};
+    explicit BitReader(std::istream& stream)
+        : stream_(stream), buffer_size_(0), char_pointer_(READER_CHAR_START_POINTER), index_(0), byte_count_(0){};
 
     bool IsEOF();
 
@@ -52,7 +53,7 @@ bool BitReader::Get(T& t, size_t bit_count) {
         if (!Get(bit_value)) {
             return false;
         }
-        new_t |= (bit_value << bit);
+        new_t |= (static_cast<T>(bit_value) << bit);
         if (bit == 0) {
             break;
         }
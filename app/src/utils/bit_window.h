@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Reader of bits of bytes in memory, that shows the next 64 bits at once, so that variable size codes can be
+// decoded by tables. Bits of every byte go from the highest to the lowest, bits after the end are zeros
+class BitWindow {
+public:
+    explicit BitWindow(const std::string& bytes, size_t bit_position = 0)
+        : bytes_(bytes), bit_position_(bit_position){};
+
+    // The next bits starting from the highest bit, at least 57 of them are valid
+    uint64_t Peek() const {
+        size_t byte = bit_position_ / 8;
+        uint64_t window = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            window <<= 8;
+            if (byte + i < bytes_.size()) {
+                window |= static_cast<unsigned char>(bytes_[byte + i]);
+            }
+        }
+        return window << (bit_position_ % 8);
+    }
+
+    void Skip(size_t bit_count) {
+        bit_position_ += bit_count;
+    }
+
+    // Whether position went over the end of bytes
+    bool Overrun() const {
+        return bit_position_ > bytes_.size() * 8;
+    }
+
+    size_t Position() const {
+        return bit_position_;
+    }
+
+private:
+    const std::string& bytes_;
+    size_t bit_position_;
+};
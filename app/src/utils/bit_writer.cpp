@@ -6,11 +6,11 @@ void BitWriter::Update() {
         char_pointer_ = WRITER_CHAR_START_POINTER;
         ++byte_count_;
         ++index_;
-        if (index_ < WRITER_BUFFER_SIZE) {
+        if (index_ < static_cast<std::streamsize>(WRITER_BUFFER_SIZE)) {
             buffer_[index_] = 0;
         }
     }
-    if (index_ >= WRITER_BUFFER_SIZE) {
+    if (index_ >= static_cast<std::streamsize>(WRITER_BUFFER_SIZE)) {
         stream_.write(buffer_, WRITER_BUFFER_SIZE);
         char_pointer_ = WRITER_CHAR_START_POINTER;
         buffer_[index_ = 0] = 0;
@@ -38,6 +38,34 @@ void BitWriter::Write(const LongCode& long_code) {
     }
 }
 
+// Write one byte starting from the current bit
+void BitWriter::WriteByte(unsigned char byte) {
+    if (char_pointer_ == WRITER_CHAR_START_POINTER) {
+        buffer_[index_] = static_cast<char>(byte);
+        char_pointer_ = -1;
+        Update();
+        return;
+    }
+
+    signed char used_bits = static_cast<signed char>(WRITER_CHAR_START_POINTER - char_pointer_);
+    buffer_[index_] = static_cast<char>(static_cast<unsigned char>(buffer_[index_]) | (byte >> used_bits));
+    char_pointer_ = -1;
+    Update();
+    buffer_[index_] = static_cast<char>(byte << (8 - used_bits));
+    char_pointer_ = WRITER_CHAR_START_POINTER - used_bits;
+}
+
+// Write first bit_count bits of bytes, bits of every byte go from the highest to the lowest
+void BitWriter::Write(const std::string& bytes, size_t bit_count) {
+    size_t full_bytes = bit_count / 8;
+    for (size_t i = 0; i < full_bytes; ++i) {
+        WriteByte(static_cast<unsigned char>(bytes[i]));
+    }
+    for (size_t bit = 0; bit < bit_count % 8; ++bit) {
+        Write(static_cast<bool>((bytes[full_bytes] >> (WRITER_CHAR_START_POINTER - bit)) & 1));
+    }
+}
+
 // Write one bit
 void BitWriter::operator<<(bool b) {
     Write(b);
@@ -50,7 +78,7 @@ void BitWriter::Complete() {
     }
     if (index_ > 0) {
         stream_.write(buffer_, index_);
-        index_ = 0;
+        buffer_[index_ = 0] = 0;
     }
 }
 
@@ -67,6 +95,11 @@ size_t BitWriter::ByteCount() const {
     return byte_count_;
 }
 
+// Count of written bits including bits of incomplete last byte
+size_t BitWriter::BitCount() const {
+    return byte_count_ * 8 + (WRITER_CHAR_START_POINTER - char_pointer_);
+}
+
 BitWriter::BitWriter(std::ostream& stream)
     : stream_(stream), char_pointer_(WRITER_CHAR_START_POINTER), index_(0), byte_count_(0) {
     buffer_[index_] = 0;
@@ -76,3 +109,8 @@ void FileBitWriter::Close() {
     BitWriter::Close();
     stream_.close();
 }
+
+// Get all written data, Complete should be called before to get the last incomplete byte
+std::string StringBitWriter::Str() const {
+    return stream_.str();
+}
@@ -4,6 +4,7 @@
 #include <ios>
 #include <iostream>
 #include <ostream>
+#include <sstream>
 #include <string>
 
 #include "../long_code.h"
@@ -24,9 +25,11 @@ public:
 
     void Write(const LongCode& long_code, size_t bit_count);
     void Write(const LongCode& long_code);
+    void Write(const std::string& bytes, size_t bit_count);
     void Write(bool b);
 
     size_t ByteCount() const;
+    size_t BitCount() const;
 
     void Complete();
     virtual void Close();
@@ -35,6 +38,7 @@ public:
 
 protected:
     void Update();
+    void WriteByte(unsigned char byte);
 
     std::ostream& stream_;
     BufferT buffer_[WRITER_BUFFER_SIZE];
@@ -61,3 +65,14 @@ public:
 private:
     std::ofstream stream_;
 };
+
+// BitWriter, that keeps written data in memory
+class StringBitWriter : public BitWriter {
+public:
+    StringBitWriter() : BitWriter(stream_){};
+
+    std::string Str() const;
+
+private:
+    std::ostringstream stream_;
+};
@@ -1,5 +1,7 @@
 #include "file.h"
 
+#include <algorithm>
+
 std::string File::GetPath() const {
     return path_;
 }
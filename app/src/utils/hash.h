@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Fast non-cryptographic 64-bit hash of bytes (MurmurHash64A). Data of several parts is hashed by passing hash of
+// the previous parts as seed
+inline uint64_t Hash(const std::string& bytes, uint64_t seed = 0) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+
+    uint64_t h = seed ^ (bytes.size() * m);
+
+    size_t full_words = bytes.size() / 8;
+    for (size_t i = 0; i < full_words; ++i) {
+        uint64_t k = 0;
+        std::memcpy(&k, bytes.data() + i * 8, 8);
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    size_t tail_size = bytes.size() % 8;
+    if (tail_size > 0) {
+        for (size_t i = 0; i < tail_size; ++i) {
+            h ^= static_cast<uint64_t>(static_cast<unsigned char>(bytes[full_words * 8 + i])) << (8 * i);
+        }
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+
+#include "thread_pool.h"
+
+// In-order commit stage over thread pool jobs: jobs are run by the pool ahead of the commit point, but their results
+// are committed in the calling thread strictly in the order jobs were added. No more than window jobs are kept in
+// flight, so fast jobs wait for the commit stage instead of buffering everything
+template <typename T>
+class OrderedPipeline {
+public:
+    using Job = std::function<T()>;
+    using Commit = std::function<void(T&)>;
+
+    static const size_t WINDOW_PER_THREAD = 4;
+
+    explicit OrderedPipeline(ThreadPool& pool);
+
+    OrderedPipeline(const OrderedPipeline&) = delete;
+    OrderedPipeline& operator=(const OrderedPipeline&) = delete;
+
+    ~OrderedPipeline();
+
+    void Add(std::shared_future<void> dependency, Job job, Commit commit);
+    void Finish();
+
+private:
+    struct Unit {
+        std::shared_future<void> dependency;  // Job is submitted only after dependency is ready
+        Job job;
+        Commit commit;
+        std::future<T> result;
+    };
+
+    void SubmitReady();
+    void Submit(Unit& unit);
+    void CommitFront();
+
+    ThreadPool& pool_;
+    const size_t window_;
+
+    std::deque<Unit> units_;
+    size_t submitted_count_;  // Units are submitted in order, so submitted ones are the first in units_
+};
+
+template <typename T>
+OrderedPipeline<T>::OrderedPipeline(ThreadPool& pool)
+    : pool_(pool), window_(pool.Size() * WINDOW_PER_THREAD), submitted_count_(0) {
+}
+
+// Wait for jobs in flight, they may use data of the caller
+template <typename T>
+OrderedPipeline<T>::~OrderedPipeline() {
+    for (size_t i = 0; i < submitted_count_; ++i) {
+        units_[i].result.wait();
+    }
+}
+
+// Add job, which result is committed after results of all previous jobs
+template <typename T>
+void OrderedPipeline<T>::Add(std::shared_future<void> dependency, Job job, Commit commit) {
+    units_.push_back({.dependency = std::move(dependency), .job = std::move(job), .commit = std::move(commit)});
+    SubmitReady();
+    while (units_.size() > window_) {
+        CommitFront();
+        SubmitReady();
+    }
+}
+
+// Commit all added jobs
+template <typename T>
+void OrderedPipeline<T>::Finish() {
+    while (!units_.empty()) {
+        SubmitReady();
+        CommitFront();
+    }
+}
+
+template <typename T>
+void OrderedPipeline<T>::Submit(Unit& unit) {
+    unit.result = pool_.Submit(std::move(unit.job));
+    ++submitted_count_;
+}
+
+// Submit jobs in order while their dependencies are ready and window is not full
+template <typename T>
+void OrderedPipeline<T>::SubmitReady() {
+    while (submitted_count_ < units_.size() && submitted_count_ < window_) {
+        Unit& unit = units_[submitted_count_];
+        if (unit.dependency.valid() &&
+            unit.dependency.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            break;
+        }
+        Submit(unit);
+    }
+}
+
+// Wait for the first job and commit its result
+template <typename T>
+void OrderedPipeline<T>::CommitFront() {
+    Unit& unit = units_.front();
+    if (submitted_count_ == 0) {
+        if (unit.dependency.valid()) {
+            unit.dependency.wait();
+        }
+        Submit(unit);
+    }
+
+    std::future<T> result = std::move(unit.result);
+    Commit commit = std::move(unit.commit);
+    units_.pop_front();
+    --submitted_count_;
+
+    T value = result.get();
+    if (commit) {
+        commit(value);
+    }
+}
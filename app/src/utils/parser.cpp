@@ -68,7 +68,7 @@ ArgumentValue::operator std::vector<std::string>() {
 // Parsing given data in argv
 Parser::Parser(int argc, char** argv, const std::unordered_map<char, std::string>& short_defines,
                const std::unordered_set<std::string> possible_arguments) {
-    size_t i = 1;
+    int i = 1;
     std::string argument = "-";
     while (i < argc) {
         if (argv[i][0] == '-' && argv[i][1] == '-') {
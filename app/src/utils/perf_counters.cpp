@@ -0,0 +1,81 @@
+#include "perf_counters.h"
+
+#include <array>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+CounterValues CounterValues::operator-(const CounterValues& other) const {
+    return {.cycles = cycles - other.cycles,
+            .instructions = instructions - other.instructions,
+            .branch_misses = branch_misses - other.branch_misses,
+            .cache_misses = cache_misses - other.cache_misses};
+}
+
+#ifdef __linux__
+
+static constexpr std::array<uint64_t, 4> EVENTS = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                   PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+
+// Descriptors of counters of one thread in order of EVENTS, -1 for events, that can't be counted
+class ThreadCounters {
+public:
+    ThreadCounters() {
+        for (size_t event = 0; event < EVENTS.size(); ++event) {
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = EVENTS[event];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds_[event] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            opened_ = opened_ || fds_[event] >= 0;
+        }
+    }
+
+    ~ThreadCounters() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    std::optional<CounterValues> Read() const {
+        if (!opened_) {
+            return std::nullopt;
+        }
+        std::array<uint64_t, EVENTS.size()> values = {};
+        for (size_t event = 0; event < EVENTS.size(); ++event) {
+            if (fds_[event] >= 0 && read(fds_[event], &values[event], sizeof(uint64_t)) != sizeof(uint64_t)) {
+                values[event] = 0;
+            }
+        }
+        return CounterValues{
+            .cycles = values[0], .instructions = values[1], .branch_misses = values[2], .cache_misses = values[3]};
+    }
+
+private:
+    std::array<int, EVENTS.size()> fds_ = {};
+    bool opened_ = false;
+};
+
+std::optional<CounterValues> PerfCounters::Read() {
+    static thread_local const ThreadCounters counters;
+    return counters.Read();
+}
+
+#else
+
+std::optional<CounterValues> PerfCounters::Read() {
+    return std::nullopt;
+}
+
+#endif
+
+bool PerfCounters::Available() {
+    return Read().has_value();
+}
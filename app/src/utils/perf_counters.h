@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+// Hardware counters of user space code of one thread
+struct CounterValues {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t branch_misses = 0;
+    uint64_t cache_misses = 0;
+
+    CounterValues operator-(const CounterValues& other) const;
+};
+
+// Counters are opened by perf_event_open for every thread on its first read and stay open while it runs. Kernel may
+// forbid them (perf_event_paranoid, containers, virtual machines) or lack some events: absent events read as zero,
+// and nothing is read, if there are no events at all
+class PerfCounters {
+public:
+    static std::optional<CounterValues> Read();
+    static bool Available();
+};
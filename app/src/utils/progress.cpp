@@ -0,0 +1,135 @@
+#include "progress.h"
+
+#include <algorithm>
+
+#include "round.h"
+#include "weight.h"
+
+Progress::~Progress() {
+    Stop();
+}
+
+FileProgress* Progress::AddFile(const std::string& name, uint64_t total_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return &files_.emplace_back(name, total_bytes);
+}
+
+void Progress::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reporter_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    start_ = std::chrono::steady_clock::now();
+    reporter_ = std::thread([this] { Report(); });
+}
+
+void Progress::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!reporter_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+    }
+    stopped_.notify_all();
+    reporter_.join();
+    Print(Snapshot(), 0, std::chrono::steady_clock::now() - start_, true);
+}
+
+ProgressSnapshot Progress::Snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProgressSnapshot snapshot;
+    snapshot.files_count = files_.size();
+    for (const auto& file : files_) {
+        uint64_t done_bytes = file.done_bytes.load(std::memory_order_relaxed);
+        snapshot.done_bytes += done_bytes;
+        if (file.total_bytes == UNKNOWN_SIZE) {
+            snapshot.total_known = false;
+        } else {
+            snapshot.total_bytes += file.total_bytes;
+        }
+
+        if (file.finished.load(std::memory_order_relaxed) ||
+            (file.total_bytes != UNKNOWN_SIZE && done_bytes >= file.total_bytes)) {
+            ++snapshot.finished_count;
+        } else if (done_bytes > 0) {
+            snapshot.active.push_back(&file);
+        }
+    }
+    return snapshot;
+}
+
+// Loop of reporter thread, counters are read without stopping workers
+void Progress::Report() {
+    uint64_t previous_bytes = 0;
+    auto previous_time = start_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_.wait_for(lock, interval_, [this] { return stopping_; })) {
+        lock.unlock();
+        ProgressSnapshot snapshot = Snapshot();
+        auto now = std::chrono::steady_clock::now();
+        Print(snapshot, snapshot.done_bytes - previous_bytes, now - previous_time, false);
+        previous_bytes = snapshot.done_bytes;
+        previous_time = now;
+        lock.lock();
+    }
+}
+
+// Print one line: average and current throughput, ETA by average throughput and files, that are in work
+void Progress::Print(const ProgressSnapshot& snapshot, uint64_t interval_bytes, std::chrono::nanoseconds interval,
+                     bool final) {
+    auto seconds = [](std::chrono::nanoseconds duration) {
+        return std::chrono::duration_cast<std::chrono::duration<long double>>(duration).count();
+    };
+    auto speed = [](uint64_t bytes, long double seconds) {
+        return std::string(Weight(seconds > 0 ? static_cast<size_t>(bytes / seconds) : 0)) + "/s";
+    };
+    long double elapsed = seconds(std::chrono::steady_clock::now() - start_);
+
+    if (final) {
+        stream_ << "Progress: done " << Weight(snapshot.done_bytes) << " of " << snapshot.files_count
+                << (snapshot.files_count == 1 ? " file" : " files") << " in " << Round(elapsed, 1) << "s, "
+                << speed(snapshot.done_bytes, elapsed) << "." << std::endl;
+        return;
+    }
+
+    stream_ << "Progress: ";
+    if (snapshot.total_known && snapshot.total_bytes > 0) {
+        stream_ << Round(static_cast<long double>(snapshot.done_bytes) / snapshot.total_bytes * 100, 2) << "% ("
+                << Weight(snapshot.done_bytes) << " of " << Weight(snapshot.total_bytes) << ")";
+    } else {
+        stream_ << Weight(snapshot.done_bytes);
+    }
+    stream_ << ", " << speed(snapshot.done_bytes, elapsed) << ", now " << speed(interval_bytes, seconds(interval));
+    if (snapshot.total_known) {
+        stream_ << ", ETA ";
+        if (snapshot.done_bytes > 0) {
+            long double remaining = static_cast<long double>(
+                snapshot.total_bytes - std::min(snapshot.done_bytes, snapshot.total_bytes));
+            stream_ << Round(remaining * elapsed / snapshot.done_bytes, 1) << "s";
+        } else {
+            stream_ << "unknown";
+        }
+    }
+    stream_ << ", files " << snapshot.finished_count;
+    if (snapshot.total_known) {
+        stream_ << " of " << snapshot.files_count;
+    }
+    stream_ << " done";
+
+    for (size_t file = 0; file < snapshot.active.size() && file < MAX_PRINTED_FILES; ++file) {
+        const FileProgress& active = *snapshot.active[file];
+        uint64_t done_bytes = active.done_bytes.load(std::memory_order_relaxed);
+        stream_ << (file == 0 ? ", active: " : ", ") << active.name << " ";
+        if (active.total_bytes == UNKNOWN_SIZE) {
+            stream_ << Weight(done_bytes);
+        } else {
+            stream_ << Round(static_cast<long double>(done_bytes) / active.total_bytes * 100, 1) << "%";
+        }
+    }
+    if (snapshot.active.size() > MAX_PRINTED_FILES) {
+        stream_ << ", " << snapshot.active.size() - MAX_PRINTED_FILES << " more";
+    }
+    stream_ << std::endl;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Processed bytes of one file. Workers only bump the counter, it isn't ordered with anything else
+struct FileProgress {
+    FileProgress(std::string name, uint64_t total_bytes) : name(std::move(name)), total_bytes(total_bytes){};
+
+    const std::string name;
+    const uint64_t total_bytes;
+    std::atomic<uint64_t> done_bytes = 0;
+    std::atomic<bool> finished = false;  // File of unknown size is finished only by mark
+};
+
+// Progress of all files at one moment
+struct ProgressSnapshot {
+    uint64_t done_bytes = 0;
+    uint64_t total_bytes = 0;  // Sum of known sizes
+    bool total_known = true;   // Sizes of all files are known, so ETA may be computed
+    size_t files_count = 0;
+    size_t finished_count = 0;
+    std::vector<const FileProgress*> active;  // Files, that are started, but not finished
+};
+
+// Progress of long run. Hot loops only add bytes to relaxed atomic counter of their file, and a separate reporter
+// thread reads counters every interval and prints throughput, ETA and status of files, so workers never take a lock
+class Progress {
+public:
+    static constexpr uint64_t UNKNOWN_SIZE = std::numeric_limits<uint64_t>::max();
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{1000};
+    static constexpr std::chrono::milliseconds MAX_INTERVAL{3600000};  // One hour
+    static constexpr size_t MAX_PRINTED_FILES = 4;  // Active files are printed up to this count
+
+    explicit Progress(std::ostream& stream, std::chrono::milliseconds interval = DEFAULT_INTERVAL)
+        : stream_(stream), interval_(interval){};
+    ~Progress();
+
+    // Add file and return its counter, that stays valid for the lifetime of progress. Size may be unknown, like in
+    // decompression of stream archive
+    FileProgress* AddFile(const std::string& name, uint64_t total_bytes = UNKNOWN_SIZE);
+
+    // Count processed bytes of file, nothing is counted for null file, so code may count bytes unconditionally
+    static void Add(FileProgress* file, uint64_t bytes) {
+        if (file != nullptr) {
+            file->done_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    // Mark file as finished, it's needed only for files of unknown size
+    static void Finish(FileProgress* file) {
+        if (file != nullptr) {
+            file->finished.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // Start and stop reporter thread, that prints progress every interval and the final line after stop
+    void Start();
+    void Stop();
+
+    ProgressSnapshot Snapshot() const;
+
+private:
+    void Report();
+    void Print(const ProgressSnapshot& snapshot, uint64_t interval_bytes, std::chrono::nanoseconds interval,
+               bool final);
+
+    std::ostream& stream_;
+    const std::chrono::milliseconds interval_;
+    mutable std::mutex mutex_;
+    std::condition_variable stopped_;
+    std::deque<FileProgress> files_;  // Deque keeps counters in place, while files are added
+    std::chrono::steady_clock::time_point start_;
+    bool stopping_ = false;
+    std::thread reporter_;
+};
@@ -0,0 +1,202 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+
+#include "round.h"
+#include "weight.h"
+
+std::string_view StageName(Stage stage) {
+    switch (stage) {
+        case Stage::READ:
+            return "read";
+        case Stage::HISTOGRAM:
+            return "histogram";
+        case Stage::TABLE:
+            return "table";
+        case Stage::ENCODE:
+            return "encode";
+        case Stage::DECODE:
+            return "decode";
+        case Stage::WRITE:
+            return "write";
+    }
+    return "unknown";
+}
+
+StageTotals& StageTotals::operator+=(const StageTotals& other) {
+    wall_ns += other.wall_ns;
+    cpu_ns += other.cpu_ns;
+    bytes_in += other.bytes_in;
+    bytes_out += other.bytes_out;
+    counters.cycles += other.counters.cycles;
+    counters.instructions += other.counters.instructions;
+    counters.branch_misses += other.counters.branch_misses;
+    counters.cache_misses += other.counters.cache_misses;
+    allocations += other.allocations;
+    allocated_bytes += other.allocated_bytes;
+    peak_live_bytes = std::max(peak_live_bytes, other.peak_live_bytes);
+    return *this;
+}
+
+void Stats::EnableCounters() {
+    counters_enabled_ = true;
+}
+
+bool Stats::CountersEnabled() const {
+    return counters_enabled_;
+}
+
+size_t Stats::AddFile(const std::string& name, uint64_t raw_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.push_back({.name = name, .raw_bytes = raw_bytes});
+    return files_.size() - 1;
+}
+
+void Stats::Record(size_t file, Stage stage, const StageTotals& totals) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file < files_.size()) {
+        files_[file].stages[static_cast<size_t>(stage)] += totals;
+    }
+    total_[static_cast<size_t>(stage)] += totals;
+}
+
+void Stats::AddSizes(size_t file, uint64_t raw_bytes, uint64_t archive_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file < files_.size()) {
+        files_[file].raw_bytes += raw_bytes;
+        files_[file].archive_bytes += archive_bytes;
+    }
+}
+
+void Stats::AddCodec(size_t file, std::string_view codec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file < files_.size()) {
+        ++files_[file].codecs[std::string(codec)];
+    }
+}
+
+std::vector<FileStats> Stats::Files() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_;
+}
+
+std::array<StageTotals, STAGES_COUNT> Stats::Total() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+}
+
+// Print stages, that were run, one per line
+static void PrintStages(std::ostream& stream, const std::array<StageTotals, STAGES_COUNT>& stages) {
+    for (size_t stage = 0; stage < STAGES_COUNT; ++stage) {
+        const StageTotals& totals = stages[stage];
+        if (totals.wall_ns == 0 && totals.bytes_in == 0 && totals.bytes_out == 0) {
+            continue;
+        }
+        stream << "  " << StageName(static_cast<Stage>(stage)) << ": " << totals.wall_ns / 1000000 << "ms wall, "
+               << totals.cpu_ns / 1000000 << "ms CPU, " << Weight(totals.bytes_in) << " in, "
+               << Weight(totals.bytes_out) << " out";
+        const CounterValues& counters = totals.counters;
+        if (counters.cycles > 0 && totals.bytes_in > 0) {
+            auto per_byte = [&totals](uint64_t count) {
+                return static_cast<long double>(count) / static_cast<long double>(totals.bytes_in);
+            };
+            stream << ", " << Round(per_byte(counters.cycles), 2) << " cycles/byte, IPC "
+                   << Round(static_cast<long double>(counters.instructions) / counters.cycles, 2) << ", "
+                   << Round(per_byte(counters.branch_misses) * 1024, 2) << " branch misses/Kb, "
+                   << Round(per_byte(counters.cache_misses) * 1024, 2) << " cache misses/Kb";
+        }
+        if (AllocationCounter::Enabled()) {
+            // Writing stages take nothing in, so their allocations are counted per megabyte out
+            uint64_t bytes = totals.bytes_in > 0 ? totals.bytes_in : totals.bytes_out;
+            stream << ", " << totals.allocations << " allocations";
+            if (bytes > 0) {
+                long double per_megabyte = static_cast<long double>(totals.allocations) * (1 << 20) / bytes;
+                stream << " (" << Round(per_megabyte, 2) << "/Mb)";
+            }
+            stream << ", " << Weight(totals.allocated_bytes) << " allocated, peak " << Weight(totals.peak_live_bytes)
+                   << " live";
+        }
+        stream << std::endl;
+    }
+}
+
+void Stats::Print(std::ostream& stream) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stream << "Stages of files:" << std::endl;
+    for (const auto& file : files_) {
+        stream << "- " << file.name << std::endl;
+        PrintStages(stream, file.stages);
+        if (!file.codecs.empty()) {
+            stream << "  blocks:";
+            for (const auto& [codec, count] : file.codecs) {
+                stream << " " << codec << " " << count;
+            }
+            stream << std::endl;
+        }
+    }
+    stream << "Stages in total:" << std::endl;
+    PrintStages(stream, total_);
+    if (counters_enabled_ && !PerfCounters::Available()) {
+        stream << "Hardware counters are unavailable" << std::endl;
+    }
+    if (AllocationCounter::Enabled()) {
+        stream << "Peak live memory of new: " << Weight(AllocationCounter::ProcessPeakLiveBytes()) << std::endl;
+    }
+}
+
+size_t PeakMemory() {
+    // Kernel keeps the peak as VmHWM line in kilobytes
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        size_t digits = line.find_first_of("0123456789");
+        if (line.rfind("VmHWM:", 0) == 0 && digits != std::string::npos) {
+            return std::stoul(line.substr(digits)) * 1024;
+        }
+    }
+    return 0;
+}
+
+// CPU time of the calling thread in nanoseconds
+static uint64_t ThreadCpuTime() {
+    timespec time = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<uint64_t>(time.tv_sec) * 1000000000 + static_cast<uint64_t>(time.tv_nsec);
+}
+
+StageTimer::StageTimer(Stats* stats, Stage stage) : stats_(stats), stage_(stage) {
+    if (stats_ != nullptr) {
+        wall_start_ = std::chrono::steady_clock::now();
+        cpu_start_ = ThreadCpuTime();
+        if (stats_->CountersEnabled()) {
+            counters_start_ = PerfCounters::Read();
+        }
+        previous_peak_ = AllocationCounter::ResetPeak();
+        allocations_start_ = AllocationCounter::Read();
+    }
+}
+
+// Record time since construction and bytes, that stage took and produced
+void StageTimer::Stop(size_t file, uint64_t bytes_in, uint64_t bytes_out) {
+    if (stats_ == nullptr) {
+        return;
+    }
+    CounterValues counters;
+    if (counters_start_) {
+        counters = PerfCounters::Read().value_or(*counters_start_) - *counters_start_;
+    }
+    AllocationValues allocations = AllocationCounter::Read() - allocations_start_;
+    AllocationCounter::RestorePeak(previous_peak_);
+    auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wall_start_);
+    stats_->Record(file, stage_,
+                   {.wall_ns = static_cast<uint64_t>(wall.count()),
+                    .cpu_ns = ThreadCpuTime() - cpu_start_,
+                    .bytes_in = bytes_in,
+                    .bytes_out = bytes_out,
+                    .counters = counters,
+                    .allocations = allocations.allocations,
+                    .allocated_bytes = allocations.bytes,
+                    .peak_live_bytes = static_cast<uint64_t>(std::max<int64_t>(allocations.peak_live_bytes, 0))});
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "perf_counters.h"
+
+// Stages of compression and decompression, that are measured separately
+enum class Stage : size_t {
+    READ = 0,       // Reading of input files or archive
+    HISTOGRAM = 1,  // Counting of bytes
+    TABLE = 2,      // Building or reading of code tables
+    ENCODE = 3,
+    DECODE = 4,
+    WRITE = 5,  // Writing of archive or output files
+};
+static constexpr size_t STAGES_COUNT = 6;
+
+std::string_view StageName(Stage stage);
+
+// Time and bytes of one stage. Jobs of stage run in several threads at once, so times are sums over all jobs and may
+// exceed wall time of the whole run. Wall time much larger than CPU time means, that stage waits, usually for disk
+struct StageTotals {
+    uint64_t wall_ns = 0;
+    uint64_t cpu_ns = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    CounterValues counters;  // Hardware counters, if they are enabled and available
+
+    // Allocations of new, if they are counted. Peak is the largest memory, that one job of stage held at once
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t peak_live_bytes = 0;
+
+    StageTotals& operator+=(const StageTotals& other);
+};
+
+struct FileStats {
+    std::string name;
+    uint64_t raw_bytes = 0;      // Size of file
+    uint64_t archive_bytes = 0;  // Size of its encoded data in archive
+    std::array<StageTotals, STAGES_COUNT> stages = {};
+    std::map<std::string, size_t> codecs;  // Count of blocks by names of their codecs
+};
+
+// Statistics of stages per file and in total. Stages are recorded once per block, so methods take a lock and may be
+// called by any thread
+class Stats {
+public:
+    static constexpr size_t NO_FILE = std::numeric_limits<size_t>::max();  // Stage is counted only in total
+
+    // Count hardware events of stages, must be called before stages are recorded
+    void EnableCounters();
+    bool CountersEnabled() const;
+
+    // Add file and return its index for other methods
+    size_t AddFile(const std::string& name, uint64_t raw_bytes = 0);
+
+    void Record(size_t file, Stage stage, const StageTotals& totals);
+    void AddSizes(size_t file, uint64_t raw_bytes, uint64_t archive_bytes);
+    void AddCodec(size_t file, std::string_view codec);
+
+    std::vector<FileStats> Files() const;
+    std::array<StageTotals, STAGES_COUNT> Total() const;
+
+    void Print(std::ostream& stream) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<FileStats> files_;
+    std::array<StageTotals, STAGES_COUNT> total_ = {};
+    bool counters_enabled_ = false;
+};
+
+// Peak resident memory of the process in bytes, zero if it is unknown
+size_t PeakMemory();
+
+// Measures wall time, CPU time, hardware counters and allocations of the calling thread from its construction to Stop.
+// Nothing is measured, if stats are null, so code may be timed unconditionally
+class StageTimer {
+public:
+    StageTimer(Stats* stats, Stage stage);
+
+    void Stop(size_t file, uint64_t bytes_in, uint64_t bytes_out);
+
+private:
+    Stats* stats_;
+    Stage stage_;
+    std::chrono::steady_clock::time_point wall_start_;
+    uint64_t cpu_start_ = 0;
+    std::optional<CounterValues> counters_start_;
+    AllocationValues allocations_start_;
+    int64_t previous_peak_ = 0;
+};
@@ -0,0 +1,111 @@
+#include "thread_pool.h"
+
+// Pool and index of the worker, that runs in the current thread
+static thread_local const ThreadPool* current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+
+// Count of hardware threads, at least one
+size_t ThreadPool::DefaultThreadsCount() {
+    size_t threads_count = std::thread::hardware_concurrency();
+    return threads_count > 0 ? threads_count : 1;
+}
+
+ThreadPool::ThreadPool(size_t threads_count) : pending_(0), stop_(false) {
+    if (threads_count == 0) {
+        threads_count = DefaultThreadsCount();
+    }
+    for (size_t i = 0; i < threads_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads_count; ++i) {
+        threads_.emplace_back(&ThreadPool::Work, this, i);
+    }
+}
+
+// Finish all submitted tasks and stop workers
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::Size() const {
+    return workers_.size();
+}
+
+// Tasks from workers go to their own deques, other tasks go to the shared queue
+void ThreadPool::Push(Task task) {
+    Worker& worker = current_pool == this ? *workers_[current_worker] : injected_;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++pending_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+// Take the newest task of worker
+bool ThreadPool::TryPop(size_t worker_index, Task& task) {
+    Worker& worker = *workers_[worker_index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+// Take the oldest task submitted outside of the pool
+bool ThreadPool::TryPopInjected(Task& task) {
+    std::lock_guard<std::mutex> lock(injected_.mutex);
+    if (injected_.tasks.empty()) {
+        return false;
+    }
+    task = std::move(injected_.tasks.front());
+    injected_.tasks.pop_front();
+    return true;
+}
+
+// Take the oldest task of any other worker
+bool ThreadPool::TrySteal(size_t worker_index, Task& task) {
+    for (size_t shift = 1; shift < workers_.size(); ++shift) {
+        Worker& victim = *workers_[(worker_index + shift) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Worker loop: run tasks while there are any, sleep otherwise
+void ThreadPool::Work(size_t worker_index) {
+    current_pool = this;
+    current_worker = worker_index;
+
+    while (true) {
+        Task task;
+        if (TryPop(worker_index, task) || TryPopInjected(task) || TrySteal(worker_index, task)) {
+            --pending_;
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0) {
+            return;
+        }
+    }
+}
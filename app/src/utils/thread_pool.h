@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool: every worker has its own deque of tasks, takes new tasks from its back and steals
+// the oldest tasks from other workers when its deque is empty. Tasks submitted outside of the pool go to a shared
+// queue and are started in the order of submission
+class ThreadPool {
+public:
+    static constexpr size_t MAX_THREADS_COUNT = 1024;
+
+    explicit ThreadPool(size_t threads_count = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    size_t Size() const;
+
+    template <typename F>
+    auto Submit(F f) -> std::future<decltype(f())>;
+
+    static size_t DefaultThreadsCount();
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    void Push(Task task);
+    bool TryPop(size_t worker_index, Task& task);
+    bool TryPopInjected(Task& task);
+    bool TrySteal(size_t worker_index, Task& task);
+    void Work(size_t worker_index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    Worker injected_;  // Tasks from threads outside of the pool
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> pending_;  // Count of tasks, that are waiting in deques
+    bool stop_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+};
+
+// Run f in pool and get future of its result
+template <typename F>
+auto ThreadPool::Submit(F f) -> std::future<decltype(f())> {
+    using ResultT = decltype(f());
+
+    auto task = std::make_shared<std::packaged_task<ResultT()>>(std::move(f));
+    std::future<ResultT> result = task->get_future();
+    Push([task] { (*task)(); });
+    return result;
+}
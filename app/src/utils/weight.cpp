@@ -1,5 +1,6 @@
 #include "weight.h"
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
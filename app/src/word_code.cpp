@@ -0,0 +1,228 @@
+#include "word_code.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "canonical_code.h"
+#include "decompressor.h"
+#include "utils/bit_window.h"
+
+std::vector<size_t> WordCounts(const std::string& data) {
+    std::vector<size_t> counts(WORD_SYMBOLS_COUNT, 0);
+    for (size_t i = 0; i + 1 < data.size(); i += 2) {
+        ++counts[static_cast<unsigned char>(data[i]) | static_cast<unsigned char>(data[i + 1]) << 8];
+    }
+    return counts;
+}
+
+// Elias gamma code of positive number: count of its bits minus one by zeros, then the number
+static size_t GammaBitCount(size_t value) {
+    return 2 * std::bit_width(value) - 1;
+}
+
+static void WriteGamma(BitWriter& bit_writer, size_t value) {
+    size_t bit_count = std::bit_width(value);
+    bit_writer.Write(0, bit_count - 1);
+    bit_writer.Write(value, bit_count);
+}
+
+static bool ReadGamma(BitReader& bit_reader, size_t& value) {
+    size_t bit_count = 1;
+    bool bit = false;
+    while (bit_reader.Get(bit) && !bit) {
+        if (++bit_count > WORD_COUNT_BIT_COUNT) {
+            return false;
+        }
+    }
+    if (!bit) {
+        return false;
+    }
+    value = 1;
+    size_t rest = 0;
+    if (bit_count > 1 && !bit_reader.Get(rest, bit_count - 1)) {
+        return false;
+    }
+    value = value << (bit_count - 1) | rest;
+    return true;
+}
+
+WordCodeTable BuildWordCodeTable(const std::vector<size_t>& counts) {
+    std::vector<size_t> sizes = HuffmanCodeSizes(counts);
+    WordCodeTable table;
+    for (size_t word = 0; word < sizes.size(); ++word) {
+        if (sizes[word] > 0) {
+            table.words.push_back(static_cast<uint16_t>(word));
+            table.code_sizes.push_back(sizes[word]);
+        }
+    }
+
+    table.bit_count = WORD_COUNT_BIT_COUNT + WriteCodeSizes(nullptr, table.code_sizes);
+    size_t previous = 0;
+    for (size_t word : table.words) {
+        table.bit_count += GammaBitCount(word + 1 - previous);
+        previous = word + 1;
+    }
+    return table;
+}
+
+size_t WordCodeTable::EstimateBitCount(const std::vector<size_t>& counts) const {
+    size_t result = BitCount();
+    for (size_t i = 0; i < words.size(); ++i) {
+        result += counts[words[i]] * code_sizes[i];
+    }
+    return result;
+}
+
+size_t WordCodeTable::BitCount() const {
+    return bit_count;
+}
+
+void WordCodeTable::Write(BitWriter& bit_writer) const {
+    bit_writer.Write(words.size(), WORD_COUNT_BIT_COUNT);
+    size_t previous = 0;
+    for (size_t word : words) {
+        WriteGamma(bit_writer, word + 1 - previous);
+        previous = word + 1;
+    }
+    WriteCodeSizes(&bit_writer, code_sizes);
+}
+
+WordCodeTable WordCodeTable::Read(BitReader& bit_reader) {
+    WordCodeTable table;
+    size_t count = 0;
+    if (!bit_reader.Get(count, WORD_COUNT_BIT_COUNT) || count == 0 || count > WORD_SYMBOLS_COUNT) {
+        throw Decompressor::ArchiveDamagedError("Can't read word code table of block");
+    }
+    table.bit_count = WORD_COUNT_BIT_COUNT;
+
+    size_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t gap = 0;
+        if (!ReadGamma(bit_reader, gap) || previous + gap > WORD_SYMBOLS_COUNT) {
+            throw Decompressor::ArchiveDamagedError("Can't read word code table of block");
+        }
+        table.bit_count += GammaBitCount(gap);
+        previous += gap;
+        table.words.push_back(static_cast<uint16_t>(previous - 1));
+    }
+
+    table.code_sizes = ReadCodeSizes(bit_reader, count, table.bit_count);
+    for (size_t size : table.code_sizes) {
+        if (size == 0 || size > WordDecoder::MAX_CODE_SIZE) {
+            throw Decompressor::ArchiveDamagedError("Wrong code sizes of word code table of block");
+        }
+    }
+    return table;
+}
+
+// Counts of codes of every size of table, the first element is unused
+static std::vector<size_t> SizesCount(const WordCodeTable& table) {
+    std::vector<size_t> sizes_count(1, 0);
+    for (size_t size : table.code_sizes) {
+        sizes_count.resize(std::max(sizes_count.size(), size + 1), 0);
+        ++sizes_count[size];
+    }
+    return sizes_count;
+}
+
+WordEncoder::WordEncoder(const WordCodeTable& table)
+    : codes_(WORD_SYMBOLS_COUNT, 0), code_sizes_(WORD_SYMBOLS_COUNT, 0) {
+    // Canonical codes of size s+1 start right after codes of size s, shifted by one bit
+    std::vector<size_t> sizes_count = SizesCount(table);
+    std::vector<uint64_t> next_code(sizes_count.size(), 0);
+    uint64_t code = 0;
+    for (size_t size = 1; size < sizes_count.size(); ++size) {
+        code = (code + sizes_count[size - 1]) << 1;
+        next_code[size] = code;
+    }
+
+    // Words are in increasing order, so words of the same size get codes in their order
+    for (size_t i = 0; i < table.words.size(); ++i) {
+        size_t size = table.code_sizes[i];
+        codes_[table.words[i]] = next_code[size]++;
+        code_sizes_[table.words[i]] = static_cast<uint8_t>(size);
+    }
+}
+
+void WordEncoder::Encode(const std::string& data, BitWriter& bit_writer) const {
+    for (size_t i = 0; i + 1 < data.size(); i += 2) {
+        size_t word = static_cast<unsigned char>(data[i]) | static_cast<unsigned char>(data[i + 1]) << 8;
+        bit_writer.Write(codes_[word], code_sizes_[word]);
+    }
+    if (data.size() % 2 == 1) {
+        bit_writer.Write(static_cast<unsigned char>(data.back()), 8);
+    }
+}
+
+WordDecoder::WordDecoder(const WordCodeTable& table)
+    : order_(table.words.size()), lookup_(static_cast<size_t>(1) << LOOKUP_BITS) {
+    std::vector<size_t> sizes_count = SizesCount(table);
+    first_code_.resize(sizes_count.size());
+    first_index_.resize(sizes_count.size());
+    sizes_count_ = sizes_count;
+    uint64_t code = 0;
+    size_t index = 0;
+    for (size_t size = 1; size < sizes_count.size(); ++size) {
+        first_code_[size] = code;
+        first_index_[size] = index;
+        code = (code + sizes_count[size]) << 1;
+        index += sizes_count[size];
+        if (CodesOverflow(code, size)) {
+            throw Decompressor::ArchiveDamagedError("Word code table isn't prefix-free");
+        }
+    }
+
+    // Words are sorted by code sizes by placing every word after words of smaller sizes
+    std::vector<size_t> next_index = first_index_;
+    for (size_t i = 0; i < table.words.size(); ++i) {
+        order_[next_index[table.code_sizes[i]]++] = table.words[i];
+    }
+
+    // Every short code fills all lookup entries, which start with it
+    for (size_t size = 1; size < std::min(LOOKUP_BITS + 1, sizes_count_.size()); ++size) {
+        for (size_t i = 0; i < sizes_count_[size]; ++i) {
+            size_t start = (first_code_[size] + i) << (LOOKUP_BITS - size);
+            size_t end = start + (static_cast<size_t>(1) << (LOOKUP_BITS - size));
+            for (size_t entry = start; entry < end && entry < lookup_.size(); ++entry) {
+                lookup_[entry] = {.word = order_[first_index_[size] + i], .code_size = static_cast<uint8_t>(size)};
+            }
+        }
+    }
+}
+
+// Decode words of size bytes starting from bit_position, then the last byte of odd size
+std::string WordDecoder::Decode(const std::string& data, size_t bit_position, size_t size) const {
+    BitWindow window(data, bit_position);
+    std::string result(size, '\0');
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        uint64_t bits = window.Peek();
+        const LookupEntry* entry = &lookup_[bits >> (64 - LOOKUP_BITS)];
+        LookupEntry long_entry;
+        if (entry->code_size == 0) {
+            for (size_t code_size = LOOKUP_BITS + 1; code_size < first_code_.size(); ++code_size) {
+                uint64_t code = bits >> (64 - code_size);
+                if (code - first_code_[code_size] < sizes_count_[code_size]) {
+                    long_entry = {.word = order_[first_index_[code_size] + (code - first_code_[code_size])],
+                                  .code_size = static_cast<uint8_t>(code_size)};
+                    break;
+                }
+            }
+            if (long_entry.code_size == 0) {
+                throw Decompressor::ArchiveDamagedError("Can't decode word code");
+            }
+            entry = &long_entry;
+        }
+        result[i] = static_cast<char>(entry->word & 0xFF);
+        result[i + 1] = static_cast<char>(entry->word >> 8);
+        window.Skip(entry->code_size);
+    }
+    if (size % 2 == 1) {
+        result.back() = static_cast<char>(window.Peek() >> 56);
+        window.Skip(8);
+    }
+
+    if (window.Overrun()) {
+        throw Decompressor::ArchiveDamagedError("Block data ends before its last word");
+    }
+    return result;
+}
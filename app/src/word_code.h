@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/bit_reader.h"
+#include "utils/bit_writer.h"
+
+// Data is read by little-endian 16-bit words, so that samples of 16-bit arrays are symbols of code
+static constexpr size_t WORD_SYMBOLS_COUNT = 1 << 16;
+static constexpr size_t WORD_COUNT_BIT_COUNT = 17;
+
+// Counts of words of data, the last byte of data of odd size isn't a word
+std::vector<size_t> WordCounts(const std::string& data);
+
+// Table of canonical Huffman code of words. Alphabet is sparse, so only present words are written: their count, gaps
+// between them by Elias gamma code and their code sizes like in compact table
+struct WordCodeTable {
+    std::vector<uint16_t> words;     // Present words in increasing order
+    std::vector<size_t> code_sizes;  // Code sizes of present words
+    size_t bit_count = 0;            // Size of table in archive
+
+    // Size of data in bits, when its words have given counts
+    size_t EstimateBitCount(const std::vector<size_t>& counts) const;
+    size_t BitCount() const;
+
+    void Write(BitWriter& bit_writer) const;
+    static WordCodeTable Read(BitReader& bit_reader);
+};
+
+WordCodeTable BuildWordCodeTable(const std::vector<size_t>& counts);
+
+// Canonical codes of words. Codes are assigned by sizes counted for every size instead of sorting of words
+class WordEncoder {
+public:
+    explicit WordEncoder(const WordCodeTable& table);
+
+    // Codes of words, then the last byte of data of odd size as is
+    void Encode(const std::string& data, BitWriter& bit_writer) const;
+
+private:
+    std::vector<uint64_t> codes_;
+    std::vector<uint8_t> code_sizes_;
+};
+
+// Table-driven decoder like CanonicalDecoder, but with 16-bit symbols
+class WordDecoder {
+public:
+    static constexpr size_t LOOKUP_BITS = 11;
+    static constexpr size_t MAX_CODE_SIZE = 56;
+
+    explicit WordDecoder(const WordCodeTable& table);
+
+    std::string Decode(const std::string& data, size_t bit_position, size_t size) const;
+
+private:
+    struct LookupEntry {
+        uint16_t word = 0;
+        uint8_t code_size = 0;  // Zero for codes longer than LOOKUP_BITS
+    };
+
+    std::vector<uint16_t> order_;        // Words in canonical codes order
+    std::vector<uint64_t> first_code_;   // The first canonical code of every size
+    std::vector<size_t> first_index_;    // Index of word with the first code of every size in order_
+    std::vector<size_t> sizes_count_;    // Count of codes of every size
+    std::vector<LookupEntry> lookup_;
+};
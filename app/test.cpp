@@ -1,18 +1,45 @@
+#include <algorithm>
 #include <catch.hpp>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <optional>
 #include <queue>
+#include <random>
+#include <sstream>
+#include <thread>
 #include <vector>
 
+#include "src/archive_index.h"
+#include "src/block_codec.h"
+#include "src/bwt.h"
+#include "src/canonical_code.h"
+#include "src/compressor.h"
+#include "src/decompressor.h"
+#include "src/estimator.h"
+#include "src/filter.h"
 #include "src/long_code.h"
+#include "src/lz77.h"
+#include "src/tans.h"
+#include "src/utils/allocation_counter.h"
 #include "src/utils/bit_reader.h"
 #include "src/utils/bit_writer.h"
 #include "src/utils/counter.h"
 #include "src/utils/file.h"
+#include "src/utils/hash.h"
 #include "src/utils/parser.h"
+#include "src/utils/progress.h"
+#include "src/utils/perf_counters.h"
 #include "src/utils/priority_queue.h"
 #include "src/utils/round.h"
+#include "src/utils/stats.h"
+#include "src/utils/thread_pool.h"
 #include "src/utils/trie.h"
 #include "src/utils/weight.h"
+#include "src/word_code.h"
 
 template <typename K, typename V>
 void RequireEquality(const std::unordered_map<K, V>& actual, const std::unordered_map<K, V>& expected) {
@@ -47,6 +74,49 @@ void RequireEquality(const LongCode& actual, const LongCode& expected) {
     }
 }
 
+// Text of random words with some random bytes, that compresses like ordinary files
+std::string TestData(size_t size, unsigned seed) {
+    std::mt19937 random(seed);
+    std::string data;
+    while (data.size() < size) {
+        if (random() % 16 == 0) {
+            data += static_cast<char>(random() % 256);
+        }
+        for (size_t length = 1 + random() % 8; length > 0; --length) {
+            data += static_cast<char>('a' + random() % 6);
+        }
+        data += ' ';
+    }
+    data.resize(size);
+    return data;
+}
+
+void WriteTestFile(const std::string& path, const std::string& data) {
+    std::ofstream stream(path, std::ios::binary | std::ios::out);
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+std::string ReadTestFile(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary | std::ios::in);
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+// Decompress archive into the current directory, where its files are removed before, and check names and contents
+void RequireDecompressed(std::string archive_path, ThreadPool& pool,
+                         const std::vector<std::pair<std::string, std::string>>& contents) {
+    for (const auto& [name, data] : contents) {
+        std::remove(name.c_str());
+    }
+    Decompressor decompressor(archive_path, pool);
+    decompressor.Decompress();
+    std::vector<File> files = decompressor.GetFiles();
+    REQUIRE(files.size() == contents.size());
+    for (size_t file = 0; file < files.size(); ++file) {
+        REQUIRE(files[file].GetPath() == contents[file].first);
+        REQUIRE(ReadTestFile(contents[file].first) == contents[file].second);
+    }
+}
+
 TEST_CASE("BitStream") {
     {
         std::ostringstream oss;
@@ -114,6 +184,263 @@ TEST_CASE("BitStream") {
     }
 }
 
+TEST_CASE("StringBitWriter") {
+    {
+        StringBitWriter bit_writer;
+        bit_writer.Write(true);
+        bit_writer.Write(false);
+        bit_writer.Write(true);
+        REQUIRE(bit_writer.BitCount() == 3);
+
+        bit_writer.Write(std::string("\xF0\x0F\xC0"), 18);
+        REQUIRE(bit_writer.BitCount() == 21);
+        REQUIRE(bit_writer.ByteCount() == 2);
+
+        bit_writer.Complete();
+        REQUIRE(bit_writer.Str() == "\xBE\x01\xF8");
+    }
+
+    {
+        StringBitWriter expected_writer;
+        StringBitWriter block_writer;
+        std::string bytes;
+        for (size_t i = 0; i < 3000; ++i) {
+            bytes += static_cast<char>(i * 37);
+        }
+
+        expected_writer.Write(false);
+        expected_writer.Write(true);
+        block_writer.Write(false);
+        block_writer.Write(true);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            expected_writer.Write(static_cast<unsigned char>(bytes[i]), 8);
+        }
+        block_writer.Write(bytes, bytes.size() * 8);
+
+        REQUIRE(expected_writer.BitCount() == block_writer.BitCount());
+        expected_writer.Complete();
+        block_writer.Complete();
+        REQUIRE(expected_writer.Str() == block_writer.Str());
+    }
+
+    {
+        StringBitWriter bit_writer;
+        bit_writer.Write(static_cast<unsigned char>(0xFF), 8);
+        bit_writer.Complete();
+        bit_writer.Write(static_cast<unsigned char>(0x01), 8);
+        bit_writer.Complete();
+        REQUIRE(bit_writer.Str() == "\xFF\x01");
+    }
+}
+
+BlockHeader BlockHeaderOf(const std::string& block) {
+    std::istringstream stream(block);
+    BitReader bit_reader(stream);
+    return BlockHeader::Read(bit_reader);
+}
+
+TEST_CASE("BlockCodec") {
+    std::vector<std::string> blocks = {"", "a", "abracadabra", std::string(5000, '\0')};
+    std::string bytes;
+    for (size_t i = 0; i < 70000; ++i) {
+        bytes += static_cast<char>(i * i % 251);
+    }
+    blocks.push_back(bytes);
+    std::string text;
+    for (size_t i = 0; i < 3000; ++i) {
+        text += "the quick brown fox jumps over the lazy dog " + std::to_string(i % 7) + "\n";
+    }
+    blocks.push_back(text);
+
+    BlockEncoderOptions order1;
+    order1.order1 = true;
+    BlockEncoderOptions lz77;
+    lz77.lz77 = true;
+    BlockEncoderOptions bwt;
+    bwt.bwt = true;
+    BlockEncoderOptions tans;
+    tans.tans = true;
+    BlockEncoderOptions words;
+    words.words = true;
+    BlockEncoderOptions filters;
+    filters.filters = true;
+    for (const auto& options : {BlockEncoderOptions(), order1, lz77, bwt, tans, words, filters}) {
+        for (const auto& data : blocks) {
+            std::string block = EncodeBlock(data, options);
+            std::istringstream stream(block);
+            BitReader bit_reader(stream);
+            BlockHeader header = BlockHeader::Read(bit_reader);
+
+            REQUIRE(header.raw_size == data.size());
+            REQUIRE(header.size + BlockHeader::SIZE == block.size());
+            REQUIRE(DecodeBlock(header, block.substr(BlockHeader::SIZE)) == data);
+        }
+    }
+
+    REQUIRE(BlockHeaderOf(EncodeBlock(text, order1)).codec == BlockCodec::HUFFMAN_ORDER1);
+    REQUIRE(EncodeBlock(text, order1).size() < EncodeBlock(text).size());
+    REQUIRE(BlockHeaderOf(EncodeBlock(text, lz77)).codec == BlockCodec::LZ77);
+    REQUIRE(EncodeBlock(text, lz77).size() < EncodeBlock(text, order1).size());
+
+    std::string uniform;
+    for (size_t i = 0; i < 4096; ++i) {
+        uniform += static_cast<char>(i);
+    }
+    REQUIRE(BlockHeaderOf(EncodeBlock(uniform)).codec == BlockCodec::STORED);
+    REQUIRE(EncodeBlock(uniform).size() == BlockHeader::SIZE + uniform.size());
+    REQUIRE(BlockHeaderOf(EncodeBlock(std::string(5000, '\0'))).codec == BlockCodec::HUFFMAN);
+    REQUIRE(BlockHeaderOf(EncodeBlock(std::string(5000, '\0'))).compact_tables);
+    REQUIRE(BlockHeaderOf(EncodeBlock("")).codec == BlockCodec::STORED);
+
+    std::string skewed;
+    for (size_t i = 0; i < 20000; ++i) {
+        skewed += i % 10 == 0 ? static_cast<char>('a' + i % 7) : ' ';
+    }
+    REQUIRE(BlockHeaderOf(EncodeBlock(skewed, tans)).codec == BlockCodec::TANS);
+    REQUIRE(EncodeBlock(skewed, tans).size() < EncodeBlock(skewed).size());
+
+    // Samples of smooth signal have few distinct 16-bit values, but their bytes look random
+    std::string samples;
+    for (size_t i = 0; i < 20000; ++i) {
+        uint16_t sample = static_cast<uint16_t>(30000 + 20000 * std::sin(static_cast<double>(i) / 300));
+        sample &= 0xFFC0;
+        samples += static_cast<char>(sample & 0xFF);
+        samples += static_cast<char>(sample >> 8);
+    }
+    REQUIRE(BlockHeaderOf(EncodeBlock(samples, words)).codec == BlockCodec::WORDS);
+    REQUIRE(EncodeBlock(samples, words).size() < EncodeBlock(samples).size());
+
+    // Counter of 32-bit records changes only its lowest byte, ramp of bytes has the same difference everywhere
+    std::string counter;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        uint32_t value = 100000 + i * 3;
+        counter.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    std::string ramp;
+    for (size_t i = 0; i < 10000; ++i) {
+        ramp += static_cast<char>(i * 7);
+    }
+    for (const auto& data : {counter, ramp, samples}) {
+        std::string block = EncodeBlock(data, filters);
+        REQUIRE(block.size() < EncodeBlock(data).size() / 2);
+        BlockHeader header = BlockHeaderOf(block);
+        REQUIRE((header.codec == BlockCodec::LANES || header.filter != BlockFilter::NONE));
+        REQUIRE(DecodeBlock(header, block.substr(BlockHeader::SIZE)) == data);
+    }
+    REQUIRE(BlockHeaderOf(EncodeBlock(ramp, filters)).filter == BlockFilter::DELTA);
+}
+
+TEST_CASE("CanonicalDecoder") {
+    // Codes of sizes 1, 2, 2 fill the code space, one more code of size 2 overfills it
+    CanonicalDecoder decoder(CodeTable{.order = {'a', 'b', 'c'}, .code_sizes_count = {1, 2}});
+    size_t code_size = 0;
+    REQUIRE(decoder.Decode(uint64_t{0b11} << 62, code_size) == 'c');
+    REQUIRE(code_size == 2);
+    REQUIRE_THROWS_AS(CanonicalDecoder(CodeTable{.order = {'a', 'b', 'c', 'd'}, .code_sizes_count = {1, 3}}),
+                      Decompressor::ArchiveDamagedError);
+    REQUIRE_THROWS_AS(CanonicalDecoder(CodeTable{.order = {'a', 'b', 'c', 'd', 'e'}, .code_sizes_count = {0, 5}}),
+                      Decompressor::ArchiveDamagedError);
+}
+
+TEST_CASE("CompactCodeTable") {
+    // Fibonacci counts give codes longer than 15 bits, many equal counts give runs of sizes
+    Counter<CharT> skewed;
+    size_t previous = 1;
+    size_t current = 1;
+    for (CharT c = 0; c < 30; ++c) {
+        skewed.Add(static_cast<CharT>(c * 3), current);
+        std::tie(previous, current) = std::make_pair(current, previous + current);
+    }
+    Counter<CharT> flat;
+    for (CharT c = 0; c < 200; ++c) {
+        flat.Add(c, 10 + c % 3);
+    }
+    flat.Add(BLOCK_END);
+
+    for (auto* counter : {&skewed, &flat}) {
+        CanonicalCodeGenerator<CharT> canonical_code(*counter);
+        StringBitWriter full_writer;
+        WriteCodeTable(full_writer, canonical_code);
+        StringBitWriter bit_writer;
+        WriteCompactCodeTable(bit_writer, canonical_code);
+        WriteCompactCodeTable(bit_writer, canonical_code, &canonical_code);
+        size_t bit_count = bit_writer.BitCount();
+        REQUIRE(bit_count < full_writer.BitCount());
+        bit_writer.Complete();
+
+        std::istringstream stream(bit_writer.Str());
+        BitReader bit_reader(stream);
+        CodeTable code_table = ReadCompactCodeTable(bit_reader);
+        CodeTable reused_table = ReadCompactCodeTable(bit_reader, &code_table);
+        REQUIRE(code_table.order == canonical_code.Order());
+        REQUIRE(code_table.code_sizes_count == canonical_code.CodeSizesCount());
+        REQUIRE(reused_table.order == code_table.order);
+        REQUIRE(code_table.BitCount() + reused_table.BitCount() == bit_count);
+        REQUIRE(reused_table.BitCount() == 1);
+    }
+
+    // Blocks with full tables are still decoded
+    std::string data = "abracadabra";
+    Counter<CharT> counter;
+    for (char c : data) {
+        counter.Add(c);
+    }
+    counter.Add(BLOCK_END);
+    CanonicalCodeGenerator<CharT> canonical_code(counter);
+    StringBitWriter bit_writer;
+    WriteCodeTable(bit_writer, canonical_code);
+    for (char c : data) {
+        bit_writer.Write(canonical_code[c]);
+    }
+    bit_writer.Write(canonical_code[BLOCK_END]);
+    bit_writer.Complete();
+    BlockHeader header;
+    header.raw_size = static_cast<uint32_t>(data.size());
+    header.size = static_cast<uint32_t>(bit_writer.Str().size());
+    REQUIRE(DecodeBlock(header, bit_writer.Str()) == data);
+}
+
+TEST_CASE("SplitBlock") {
+    REQUIRE(SplitBlock("") == std::vector<size_t>{0});
+    REQUIRE(SplitBlock("abracadabra") == std::vector<size_t>{11});
+
+    std::string text;
+    while (text.size() < 200000) {
+        text += "the quick brown fox jumps over the lazy dog\n";
+    }
+    std::vector<size_t> sizes = SplitBlock(text);
+    REQUIRE(sizes == std::vector<size_t>{text.size()});
+
+    std::string binary;
+    for (size_t i = 0; i < 150000; ++i) {
+        binary += static_cast<char>(i * i * 7 % 253 + 3);
+    }
+    std::string mixed = text + binary;
+    sizes = SplitBlock(mixed);
+    REQUIRE(sizes.size() >= 2);
+    size_t sum = 0;
+    for (size_t size : sizes) {
+        sum += size;
+    }
+    REQUIRE(sum == mixed.size());
+
+    BlockEncoderOptions split;
+    split.split = true;
+    std::string blocks = EncodeBlocks(mixed, split);
+    REQUIRE(blocks.size() < EncodeBlocks(mixed).size());
+
+    std::string decoded;
+    size_t offset = 0;
+    while (offset < blocks.size()) {
+        std::istringstream stream(blocks.substr(offset, BlockHeader::SIZE));
+        BitReader bit_reader(stream);
+        BlockHeader header = BlockHeader::Read(bit_reader);
+        decoded += DecodeBlock(header, blocks.substr(offset + BlockHeader::SIZE, header.size));
+        offset += BlockHeader::SIZE + header.size;
+    }
+    REQUIRE(decoded == mixed);
+}
+
 TEST_CASE("LongCode") {
     {
         LongCode long_code({false, false, false});
@@ -209,6 +536,624 @@ TEST_CASE("PriorityQueue") {
     }
 }
 
+TEST_CASE("ThreadPool") {
+    {
+        ThreadPool pool(3);
+        REQUIRE(pool.Size() == 3);
+
+        std::vector<std::future<size_t>> results;
+        for (size_t i = 0; i < 100; ++i) {
+            results.push_back(pool.Submit([i] { return i * i; }));
+        }
+        for (size_t i = 0; i < results.size(); ++i) {
+            REQUIRE(results[i].get() == i * i);
+        }
+    }
+
+    {
+        ThreadPool pool(2);
+        std::atomic<size_t> done = 0;
+        auto outer = pool.Submit([&pool, &done] {
+            std::vector<std::future<void>> inner;
+            for (size_t i = 0; i < 50; ++i) {
+                inner.push_back(pool.Submit([&done] { ++done; }));
+            }
+            return inner;
+        });
+        for (auto& inner : outer.get()) {
+            inner.get();
+        }
+        REQUIRE(done == 50);
+
+        auto failed = pool.Submit([]() -> int { throw std::runtime_error("task failed"); });
+        REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+    }
+}
+
+TEST_CASE("Lz77") {
+    for (uint32_t value = 0; value < 100000; value += 1 + value / 7) {
+        uint32_t code = 0;
+        uint32_t extra = 0;
+        size_t extra_bit_count = 0;
+        BucketCode(value, code, extra, extra_bit_count);
+        size_t base_extra_bit_count = 0;
+        REQUIRE(BucketBase(code, base_extra_bit_count) + extra == value);
+        REQUIRE(base_extra_bit_count == extra_bit_count);
+        REQUIRE((extra >> extra_bit_count) == 0);
+    }
+
+    std::string data = "abcabcabcabcxyzxyzabcabc";
+    for (size_t i = 0; i < 1000; ++i) {
+        data += static_cast<char>('a' + i * i % 7);
+    }
+    std::vector<Lz77Token> tokens = FindMatches(data, Lz77Options());
+    std::string restored;
+    for (const auto& token : tokens) {
+        if (token.length == 0) {
+            restored += static_cast<char>(token.distance);
+            continue;
+        }
+        REQUIRE(token.length >= LZ77_MIN_MATCH);
+        REQUIRE(token.length <= LZ77_MAX_MATCH);
+        REQUIRE(token.distance <= restored.size());
+        size_t start = restored.size() - token.distance;
+        for (size_t i = 0; i < token.length; ++i) {
+            restored += restored[start + i];
+        }
+    }
+    REQUIRE(restored == data);
+    REQUIRE(tokens.size() < data.size() / 4);
+}
+
+TEST_CASE("Bwt") {
+    std::vector<std::string> blocks = {"", "a", "banana", "abracadabra", "aaaaaaaaaa", "abababababab"};
+    std::string bytes;
+    for (size_t i = 0; i < 5000; ++i) {
+        bytes += static_cast<char>(i * i % 13 + (i % 100 == 0 ? 200 : 0));
+    }
+    blocks.push_back(bytes);
+
+    for (const auto& data : blocks) {
+        std::vector<int> s(data.begin(), data.end());
+        for (int& value : s) {
+            value = static_cast<unsigned char>(value);
+        }
+        std::vector<int> expected(data.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            expected[i] = static_cast<int>(i);
+        }
+        std::sort(expected.begin(), expected.end(),
+                  [&data](int a, int b) { return data.compare(a, std::string::npos, data, b) < 0; });
+        REQUIRE(SuffixArray(s, 255) == expected);
+
+        uint32_t primary_index = 0;
+        std::string last_column = BwtForward(data, primary_index);
+        REQUIRE(last_column.size() == data.size());
+        REQUIRE(BwtInverse(last_column, primary_index) == data);
+        REQUIRE(MoveToFrontRleInverse(MoveToFrontRle(last_column), data.size()) == last_column);
+    }
+
+    uint32_t primary_index = 0;
+    REQUIRE(BwtForward("banana", primary_index) == "annbaa");
+    REQUIRE(primary_index == 4);
+    REQUIRE(MoveToFrontRle(std::string(6, '\0')) == std::vector<uint16_t>{BWT_RUN_B, BWT_RUN_B});
+}
+
+TEST_CASE("Tans") {
+    std::vector<std::string> blocks = {"a", "abracadabra", std::string(300, 'z')};
+    std::string bytes;
+    for (size_t i = 0; i < 30000; ++i) {
+        bytes += static_cast<char>(i % 3 == 0 ? i * i % 256 : i % 5);
+    }
+    blocks.push_back(bytes);
+
+    for (const auto& data : blocks) {
+        std::array<size_t, TANS_SYMBOLS_COUNT> data_counts = {};
+        for (char c : data) {
+            ++data_counts[static_cast<unsigned char>(c)];
+        }
+        TansCounts counts = NormalizeCounts(data_counts);
+        size_t sum = 0;
+        for (size_t c = 0; c < TANS_SYMBOLS_COUNT; ++c) {
+            REQUIRE((counts.counts[c] > 0) == (data_counts[c] > 0));
+            sum += counts.counts[c];
+        }
+        REQUIRE(sum == static_cast<size_t>(1) << counts.table_log);
+
+        StringBitWriter bit_writer;
+        counts.Write(bit_writer);
+        TansEncoder(counts).Encode(data, bit_writer);
+        size_t bit_count = bit_writer.BitCount();
+        bit_writer.Complete();
+        std::string encoded = bit_writer.Str();
+
+        std::istringstream stream(encoded);
+        BitReader bit_reader(stream);
+        TansCounts read_counts = TansCounts::Read(bit_reader);
+        REQUIRE(read_counts.table_log == counts.table_log);
+        REQUIRE(read_counts.counts == counts.counts);
+        REQUIRE(TansDecoder(read_counts).Decode(encoded, counts.BitCount(), data.size()) == data);
+        REQUIRE(bit_count <= counts.EstimateBitCount(data_counts) + data.size() / 50 + 1);
+    }
+}
+
+TEST_CASE("WordCode") {
+    std::vector<std::string> blocks = {"ab", "abc", std::string(301, 'z')};
+    std::string samples;
+    for (size_t i = 0; i < 30000; ++i) {
+        uint16_t sample = static_cast<uint16_t>(i % 7 == 0 ? i * i : 1000 + i % 11 * 4096);
+        samples += static_cast<char>(sample & 0xFF);
+        samples += static_cast<char>(sample >> 8);
+    }
+    blocks.push_back(samples);
+
+    for (const auto& data : blocks) {
+        std::vector<size_t> counts = WordCounts(data);
+        WordCodeTable table = BuildWordCodeTable(counts);
+        for (size_t i = 0; i < table.words.size(); ++i) {
+            REQUIRE(counts[table.words[i]] > 0);
+            REQUIRE((i == 0 || table.words[i - 1] < table.words[i]));
+        }
+
+        StringBitWriter bit_writer;
+        table.Write(bit_writer);
+        REQUIRE(bit_writer.BitCount() == table.BitCount());
+        WordEncoder(table).Encode(data, bit_writer);
+        size_t bit_count = bit_writer.BitCount();
+        bit_writer.Complete();
+        std::string encoded = bit_writer.Str();
+
+        std::istringstream stream(encoded);
+        BitReader bit_reader(stream);
+        WordCodeTable read_table = WordCodeTable::Read(bit_reader);
+        REQUIRE(read_table.words == table.words);
+        REQUIRE(read_table.code_sizes == table.code_sizes);
+        REQUIRE(read_table.BitCount() == table.BitCount());
+        REQUIRE(WordDecoder(read_table).Decode(encoded, read_table.BitCount(), data.size()) == data);
+        REQUIRE(bit_count == table.EstimateBitCount(counts) + data.size() % 2 * 8);
+    }
+
+    // Codes of sizes 1, 2, 2, 2 overfill the code space
+    REQUIRE_NOTHROW(WordDecoder(WordCodeTable{.words = {1, 2, 3}, .code_sizes = {1, 2, 2}}));
+    REQUIRE_THROWS_AS(WordDecoder(WordCodeTable{.words = {1, 2, 3, 4}, .code_sizes = {1, 2, 2, 2}}),
+                      Decompressor::ArchiveDamagedError);
+}
+
+TEST_CASE("Filters") {
+    std::string data;
+    for (size_t i = 0; i < 1001; ++i) {
+        data += static_cast<char>(i * i % 253);
+    }
+    for (size_t filter = 0; filter < BLOCK_FILTERS_COUNT; ++filter) {
+        std::string filtered = ApplyFilter(data, static_cast<BlockFilter>(filter));
+        REQUIRE(filtered.size() == data.size());
+        RevertFilter(filtered, static_cast<BlockFilter>(filter));
+        REQUIRE(filtered == data);
+    }
+    REQUIRE(ApplyFilter("\x01\x03\x06\x0A", BlockFilter::DELTA) == std::string("\x01\x02\x03\x04"));
+    REQUIRE(ApplyFilter("\x01\x03\x06\x0A", BlockFilter::DELTA2) == std::string("\x01\x03\x05\x07"));
+
+    for (size_t lanes_count : {1, 2, 4, 8}) {
+        std::vector<std::string> lanes = SplitLanes(data, lanes_count);
+        REQUIRE(lanes.size() == lanes_count);
+        REQUIRE(lanes[0][1] == data[lanes_count]);
+        REQUIRE(MergeLanes(lanes) == data);
+    }
+    REQUIRE(SplitLanes("abcde", 2) == std::vector<std::string>{"ace", "bd"});
+}
+
+TEST_CASE("BlockCoders") {
+    std::vector<std::string_view> names;
+    for (size_t codec = 0; codec < BLOCK_CODECS_COUNT; ++codec) {
+        const BlockCoder& coder = FindBlockCoder(static_cast<BlockCodec>(codec));
+        REQUIRE(coder.Codec() == static_cast<BlockCodec>(codec));
+        REQUIRE(std::find(names.begin(), names.end(), coder.Name()) == names.end());
+        names.push_back(coder.Name());
+    }
+    REQUIRE_THROWS_AS(FindBlockCoder(static_cast<BlockCodec>(BLOCK_CODECS_COUNT)),
+                      Decompressor::ArchiveDamagedError);
+
+    std::string data;
+    std::vector<std::string> words = {"the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog "};
+    for (size_t i = 0, state = 1; i < 4000; ++i) {
+        state = state * 1103515245 + 12345;
+        data += words[(state >> 16) % words.size()];
+        for (size_t j = 0; j < 3; ++j) {
+            state = state * 1103515245 + 12345;
+            data += static_cast<char>('a' + (state >> 16) % 26);
+        }
+    }
+    BlockEncoderOptions options;
+    options.bwt = true;
+    REQUIRE((EncodeBlock(data, options)[0] & BlockHeader::CODEC_MASK) == static_cast<uint8_t>(BlockCodec::BWT));
+    options.speed_weight = BlockEncoderOptions::MAX_SPEED_WEIGHT;
+    std::string encoded = EncodeBlock(data, options);
+    REQUIRE((encoded[0] & BlockHeader::CODEC_MASK) != static_cast<uint8_t>(BlockCodec::BWT));
+    std::istringstream stream(encoded);
+    BitReader bit_reader(stream);
+    BlockHeader header = BlockHeader::Read(bit_reader);
+    REQUIRE(DecodeBlock(header, encoded.substr(BlockHeader::SIZE)) == data);
+}
+
+TEST_CASE("IndexedArchive") {
+    // Files of several blocks, small and empty files are decoded by blocks in parallel and written in order
+    ThreadPool pool(3);
+    CompressionOptions options;
+    options.indexed = true;
+    options.block_size = CompressionOptions::MIN_BLOCK_SIZE;
+    std::vector<std::pair<std::string, std::string>> contents = {{"indexed_first.txt", TestData(200000, 1)},
+                                                                 {"indexed_second.txt", TestData(1000, 2)},
+                                                                 {"indexed_empty.txt", ""}};
+    std::vector<std::string> files;
+    for (const auto& [name, data] : contents) {
+        WriteTestFile(name, data);
+        files.push_back(name);
+    }
+    std::remove("indexed.arc");
+    Compressor(files, "indexed.arc", pool, options).Compress();
+    REQUIRE(ArchiveIndex::IsIndexed("indexed.arc"));
+    RequireDecompressed("indexed.arc", pool, contents);
+
+    // Appended files follow the entries, that are already in archive. They are written into a copy of archive, so
+    // copy left by killed append doesn't matter, and it is replaced or removed
+    contents.emplace_back("indexed_third.txt", TestData(70000, 3));
+    WriteTestFile(contents.back().first, contents.back().second);
+    std::vector<std::string> appended = {contents.back().first};
+    WriteTestFile("indexed.arc.tmp", "left by killed append");
+    Compressor(appended, "indexed.arc", pool, options).Append();
+    REQUIRE(ArchiveIndex::Read("indexed.arc").Entries().size() == 4);
+    REQUIRE_FALSE(std::filesystem::exists("indexed.arc.tmp"));
+    RequireDecompressed("indexed.arc", pool, contents);
+
+    // Failed append leaves archive as it was
+    std::string archive = ReadTestFile("indexed.arc");
+    std::vector<std::string> missing = {contents.back().first, "indexed_missing.txt"};
+    REQUIRE_THROWS_AS(Compressor(missing, "indexed.arc", pool, options).Append(), FileBitReader::FileNotExists);
+    REQUIRE(ReadTestFile("indexed.arc") == archive);
+    RequireDecompressed("indexed.arc", pool, contents);
+
+    // Append creates indexed archive, if there is no archive
+    std::remove("created.arc");
+    Compressor(appended, "created.arc", pool).Append();
+    REQUIRE(ArchiveIndex::IsIndexed("created.arc"));
+    RequireDecompressed("created.arc", pool, {contents.back()});
+
+    for (const auto& [name, data] : contents) {
+        std::remove(name.c_str());
+    }
+    std::remove("indexed.arc");
+    std::remove("created.arc");
+}
+
+TEST_CASE("Dedup") {
+    // Equal files are stored once and entries of copies refer to blocks of the first one, files of equal size with
+    // different content and empty files are kept apart from them
+    ThreadPool pool(2);
+    CompressionOptions options;
+    options.dedup = true;
+    options.block_size = CompressionOptions::MIN_BLOCK_SIZE;
+    std::string data = TestData(150000, 4);
+    std::string other = data;
+    other[100000] = static_cast<char>(other[100000] + 1);
+    std::vector<std::pair<std::string, std::string>> contents = {
+        {"dedup_first.txt", data}, {"dedup_other.txt", other},  {"dedup_empty.txt", ""},
+        {"dedup_copy.txt", data},  {"dedup_empty_copy.txt", ""}, {"dedup_second_copy.txt", data}};
+    std::vector<std::string> files;
+    for (const auto& [name, content] : contents) {
+        WriteTestFile(name, content);
+        files.push_back(name);
+    }
+    std::remove("dedup.arc");
+    Compressor compressor(files, "dedup.arc", pool, options);
+    compressor.Compress();
+    REQUIRE(compressor.DuplicatesCount() == 3);
+
+    ArchiveIndex index = ArchiveIndex::Read("dedup.arc");
+    const auto& entries = index.Entries();
+    REQUIRE(entries.size() == contents.size());
+    for (size_t copy : {3, 5}) {
+        REQUIRE(entries[copy].offset == entries[0].offset);
+        REQUIRE(entries[copy].size == entries[0].size);
+    }
+    REQUIRE(entries[1].offset != entries[0].offset);
+    REQUIRE(entries[1].size > 0);
+    REQUIRE(entries[4].size == entries[2].size);
+    REQUIRE(entries[4].raw_size == 0);
+    REQUIRE(std::filesystem::file_size("dedup.arc") < data.size() * 2);
+    RequireDecompressed("dedup.arc", pool, contents);
+
+    for (const auto& [name, content] : contents) {
+        std::remove(name.c_str());
+    }
+    std::remove("dedup.arc");
+}
+
+TEST_CASE("SolidArchive") {
+    // Runs of small files share blocks, entries keep positions of files in decoded data of their group. Empty file
+    // joins the group, larger file ends it
+    ThreadPool pool(3);
+    CompressionOptions options;
+    options.solid = true;
+    options.block_size = CompressionOptions::MIN_BLOCK_SIZE;
+    std::vector<std::pair<std::string, std::string>> contents = {
+        {"solid_first.txt", TestData(3000, 5)},
+        {"solid_second.txt", TestData(5000, 6)},
+        {"solid_empty.txt", ""},
+        {"solid_large.txt", TestData(CompressionOptions::SOLID_MAX_FILE_SIZE + 1000, 7)},
+        {"solid_third.txt", TestData(1000, 8)},
+        {"solid_fourth.txt", TestData(2000, 9)}};
+    std::vector<std::string> files;
+    for (const auto& [name, data] : contents) {
+        WriteTestFile(name, data);
+        files.push_back(name);
+    }
+    std::remove("solid.arc");
+    Compressor(files, "solid.arc", pool, options).Compress();
+    {
+        ArchiveIndex index = ArchiveIndex::Read("solid.arc");
+        const auto& entries = index.Entries();
+        REQUIRE(index.Version() == ArchiveIndex::VERSION);
+        REQUIRE(entries.size() == contents.size());
+        for (size_t entry : {1, 2}) {
+            REQUIRE(entries[entry].offset == entries[0].offset);
+            REQUIRE(entries[entry].size == entries[0].size);
+        }
+        REQUIRE(entries[0].skip == 0);
+        REQUIRE(entries[1].skip == contents[0].second.size());
+        REQUIRE(entries[2].skip == contents[0].second.size() + contents[1].second.size());
+        REQUIRE(entries[3].offset > entries[0].offset);
+        REQUIRE(entries[3].skip == 0);
+        REQUIRE(entries[4].offset > entries[3].offset);
+        REQUIRE(entries[5].offset == entries[4].offset);
+        REQUIRE(entries[5].skip == contents[4].second.size());
+    }
+    RequireDecompressed("solid.arc", pool, contents);
+
+    // Archive of the first version has no positions of entries, it is upgraded by append of solid group
+    std::vector<std::pair<std::string, std::string>> old_contents(contents.begin(), contents.begin() + 2);
+    std::vector<std::string> old_files(files.begin(), files.begin() + 2);
+    CompressionOptions indexed;
+    indexed.indexed = true;
+    std::remove("solid.arc");
+    Compressor(old_files, "solid.arc", pool, indexed).Compress();
+    {
+        ArchiveIndex index = ArchiveIndex::Read("solid.arc");
+        std::string archive = ReadTestFile("solid.arc");
+        StringBitWriter header_writer;
+        ArchiveIndex::WriteHeader(header_writer, ArchiveIndex::FIRST_VERSION);
+        header_writer.Complete();
+        index.SetVersion(ArchiveIndex::FIRST_VERSION);
+        StringBitWriter index_writer;
+        index.Write(index_writer);
+        index_writer.Complete();
+        std::string blocks = archive.substr(ArchiveIndex::HEADER_SIZE, index.Offset() - ArchiveIndex::HEADER_SIZE);
+        WriteTestFile("solid.arc", header_writer.Str() + blocks + index_writer.Str());
+    }
+    REQUIRE(ArchiveIndex::Read("solid.arc").Version() == ArchiveIndex::FIRST_VERSION);
+    RequireDecompressed("solid.arc", pool, old_contents);
+
+    std::vector<std::string> appended(files.begin() + 2, files.end());
+    Compressor(appended, "solid.arc", pool, options).Append();
+    ArchiveIndex index = ArchiveIndex::Read("solid.arc");
+    REQUIRE(index.Version() == ArchiveIndex::VERSION);
+    REQUIRE(index.Entries().size() == contents.size());
+    REQUIRE(index.Entries()[5].skip == contents[4].second.size());
+    RequireDecompressed("solid.arc", pool, contents);
+
+    for (const auto& [name, data] : contents) {
+        std::remove(name.c_str());
+    }
+    std::remove("solid.arc");
+}
+
+TEST_CASE("Stats") {
+    Stats stats;
+    REQUIRE(stats.AddFile("a") == 0);
+    REQUIRE(stats.AddFile("b") == 1);
+    stats.Record(0, Stage::READ, {.wall_ns = 10, .cpu_ns = 5, .bytes_in = 100, .bytes_out = 100});
+    stats.Record(1, Stage::READ, {.wall_ns = 20, .cpu_ns = 5, .bytes_in = 200, .bytes_out = 200});
+    stats.Record(Stats::NO_FILE, Stage::WRITE, {.wall_ns = 1, .bytes_in = 7, .bytes_out = 7});
+
+    std::vector<FileStats> files = stats.Files();
+    REQUIRE(files.size() == 2);
+    REQUIRE(files[1].name == "b");
+    REQUIRE(files[1].stages[static_cast<size_t>(Stage::READ)].bytes_in == 200);
+    REQUIRE(files[0].stages[static_cast<size_t>(Stage::WRITE)].bytes_in == 0);
+    auto total = stats.Total();
+    REQUIRE(total[static_cast<size_t>(Stage::READ)].wall_ns == 30);
+    REQUIRE(total[static_cast<size_t>(Stage::READ)].bytes_out == 300);
+    REQUIRE(total[static_cast<size_t>(Stage::WRITE)].bytes_out == 7);
+
+    StageTimer timer(&stats, Stage::ENCODE);
+    timer.Stop(0, 100, 50);
+    REQUIRE(stats.Files()[0].stages[static_cast<size_t>(Stage::ENCODE)].bytes_out == 50);
+    StageTimer disabled(nullptr, Stage::ENCODE);
+    disabled.Stop(0, 100, 50);
+
+    stats.AddSizes(1, 300, 120);
+    stats.AddCodec(1, "lz77");
+    stats.AddCodec(1, "lz77");
+    stats.AddCodec(Stats::NO_FILE, "bwt");
+    files = stats.Files();
+    REQUIRE(files[1].raw_bytes == 300);
+    REQUIRE(files[1].archive_bytes == 120);
+    REQUIRE(files[1].codecs == std::map<std::string, size_t>{{"lz77", 2}});
+}
+
+TEST_CASE("PerfCounters") {
+    CounterValues first{.cycles = 10, .instructions = 20, .branch_misses = 3, .cache_misses = 4};
+    CounterValues second{.cycles = 15, .instructions = 40, .branch_misses = 3, .cache_misses = 6};
+    CounterValues difference = second - first;
+    REQUIRE(difference.cycles == 5);
+    REQUIRE(difference.instructions == 20);
+    REQUIRE(difference.branch_misses == 0);
+    REQUIRE(difference.cache_misses == 2);
+
+    // Counters may be forbidden, then stages are measured without them
+    std::optional<CounterValues> start = PerfCounters::Read();
+    REQUIRE(start.has_value() == PerfCounters::Available());
+    Stats stats;
+    stats.EnableCounters();
+    stats.AddFile("a");
+    StageTimer timer(&stats, Stage::HISTOGRAM);
+    size_t sum = 0;
+    for (size_t i = 0; i < 100000; ++i) {
+        sum += i * i;
+    }
+    timer.Stop(0, sum > 0 ? 100000 : 0, 0);
+    if (start) {
+        REQUIRE(PerfCounters::Read()->instructions >= start->instructions);
+    } else {
+        REQUIRE(stats.Total()[static_cast<size_t>(Stage::HISTOGRAM)].counters.cycles == 0);
+    }
+}
+
+TEST_CASE("AllocationCounter") {
+    // Allocations are counted only in builds with ARCHIVER_COUNT_ALLOCATIONS option
+    Stats stats;
+    AllocationValues start = AllocationCounter::Read();
+    StageTimer timer(&stats, Stage::ENCODE);
+    {
+        auto first = std::make_unique<std::vector<char>>(1 << 20);
+        std::vector<char> second(1 << 19);
+        REQUIRE(first->size() > second.size());
+    }
+    auto kept = std::make_unique<std::vector<char>>(1 << 10);
+    timer.Stop(Stats::NO_FILE, 1 << 20, 0);
+    AllocationValues difference = AllocationCounter::Read() - start;
+    const StageTotals& totals = stats.Total()[static_cast<size_t>(Stage::ENCODE)];
+    if (AllocationCounter::Enabled()) {
+        REQUIRE(difference.allocations >= 4);
+        REQUIRE(difference.bytes >= (1 << 20) + (1 << 19) + (1 << 10));
+        REQUIRE(totals.allocations >= 4);
+        REQUIRE(totals.peak_live_bytes >= (1 << 20) + (1 << 19));
+        REQUIRE(totals.peak_live_bytes < (1 << 21));
+        REQUIRE(AllocationCounter::ProcessPeakLiveBytes() >= totals.peak_live_bytes);
+    } else {
+        REQUIRE(difference.allocations == 0);
+        REQUIRE(totals.allocations == 0);
+        REQUIRE(totals.peak_live_bytes == 0);
+    }
+    REQUIRE(kept->size() == 1 << 10);
+}
+
+TEST_CASE("Estimator") {
+    // Data, that is the same everywhere, is estimated by samples close to its real archive
+    {
+        FileBitWriter bit_writer("estimate.txt");
+        std::mt19937 random(1);
+        for (size_t i = 0; i < (3 << 20); ++i) {
+            bit_writer.Write(static_cast<char>('a' + random() % 3), 8);
+        }
+        bit_writer.Close();
+    }
+    ThreadPool pool(2);
+    std::vector<std::string> files = {"estimate.txt"};
+    for (bool indexed : {false, true}) {
+        CompressionOptions options;
+        options.indexed = indexed;
+        std::vector<FileEstimate> estimates = Estimator(files, pool, options).Estimate();
+        REQUIRE(estimates.size() == 1);
+        REQUIRE(estimates[0].raw_bytes == 3 << 20);
+        REQUIRE(estimates[0].sampled_bytes * Estimator::SAMPLED_PART == estimates[0].raw_bytes);
+        REQUIRE(estimates[0].expected_ns > 0);
+
+        Compressor(files, "estimate.arc", pool, options).Compress();
+        auto archive_bytes = static_cast<double>(std::filesystem::file_size("estimate.arc"));
+        REQUIRE(std::abs(static_cast<double>(estimates[0].archive_bytes) - archive_bytes) < archive_bytes * 0.01);
+        std::remove("estimate.arc");
+    }
+
+    // Random data isn't compressed, blocks of indexed archive are stored whole
+    {
+        std::mt19937 random(2);
+        std::string data(3 << 20, '\0');
+        for (char& c : data) {
+            c = static_cast<char>(random() % 256);
+        }
+        WriteTestFile("estimate.bin", data);
+    }
+    CompressionOptions indexed;
+    indexed.indexed = true;
+    std::vector<std::string> random_files = {"estimate.bin"};
+    std::vector<FileEstimate> estimates = Estimator(random_files, pool, indexed).Estimate();
+    REQUIRE(estimates[0].archive_bytes >= estimates[0].raw_bytes);
+    Compressor(random_files, "estimate.arc", pool, indexed).Compress();
+    auto archive_bytes = static_cast<double>(std::filesystem::file_size("estimate.arc"));
+    REQUIRE(std::abs(static_cast<double>(estimates[0].archive_bytes) - archive_bytes) < archive_bytes * 0.01);
+    std::remove("estimate.arc");
+    std::remove("estimate.bin");
+
+    REQUIRE_THROWS(Estimator({"missing.txt"}, pool, CompressionOptions()).Estimate());
+    std::remove("estimate.txt");
+}
+
+TEST_CASE("Progress") {
+    // Counters are bumped by many threads without locks and read by reporter
+    std::ostringstream output;
+    Progress progress(output, std::chrono::milliseconds(1));
+    FileProgress* first = progress.AddFile("first.txt", 4000);
+    FileProgress* second = progress.AddFile("second.txt", 4000);
+    FileProgress* unknown = progress.AddFile("unknown.txt");
+    progress.Start();
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < 4; ++worker) {
+        workers.emplace_back([first] {
+            for (size_t block = 0; block < 1000; ++block) {
+                Progress::Add(first, 1);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    Progress::Add(second, 1000);
+    Progress::Add(unknown, 500);
+    Progress::Add(nullptr, 500);
+
+    ProgressSnapshot snapshot = progress.Snapshot();
+    REQUIRE(snapshot.done_bytes == 5500);
+    REQUIRE(snapshot.total_bytes == 8000);
+    REQUIRE_FALSE(snapshot.total_known);
+    REQUIRE(snapshot.files_count == 3);
+    REQUIRE(snapshot.finished_count == 1);
+    REQUIRE(snapshot.active.size() == 2);
+    REQUIRE(snapshot.active[0]->name == "second.txt");
+
+    Progress::Finish(unknown);
+    REQUIRE(progress.Snapshot().finished_count == 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    progress.Stop();
+    REQUIRE(output.str().find("second.txt 25%") != std::string::npos);
+    REQUIRE(output.str().find("Progress: done 5.371Kb of 3 files") != std::string::npos);
+
+    // Compressor counts every pass over files: histogram and encoding in stream format, hashing and encoding with dedup
+    WriteTestFile("progress.txt", TestData(100000, 10));
+    std::vector<std::string> files = {"progress.txt", "progress.txt"};
+    ThreadPool pool(2);
+    CompressionOptions dedup;
+    dedup.dedup = true;
+    for (const auto& options : {CompressionOptions(), dedup}) {
+        Progress compression(output);
+        Compressor(files, "progress.arc", pool, options, nullptr, &compression).Compress();
+        ProgressSnapshot compressed = compression.Snapshot();
+        REQUIRE(compressed.total_bytes == 400000);
+        REQUIRE(compressed.done_bytes == compressed.total_bytes);
+        REQUIRE(compressed.finished_count == 2);
+        std::remove("progress.arc");
+    }
+    std::remove("progress.txt");
+}
+
+TEST_CASE("Hash") {
+    REQUIRE(Hash("") == Hash(""));
+    REQUIRE(Hash("archiver") == Hash(std::string("archiver")));
+    REQUIRE(Hash("archiver") != Hash("archives"));
+    REQUIRE(Hash("archiver") != Hash("archiver", 1));
+    REQUIRE(Hash(std::string(9, '\0')) != Hash(std::string(10, '\0')));
+    REQUIRE(Hash("ver", Hash("archi")) == Hash("ver", Hash("archi")));
+}
+
 TEST_CASE("Round") {
     {
         REQUIRE(Round(123.2, 0) == 123);
@@ -0,0 +1,248 @@
+import argparse
+import filecmp
+import json
+import os
+import shlex
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+MEGABYTE = 1 << 20
+
+# Generated inputs are written by generate_corpus from one seed, so every run and every build measures the same
+# bytes. Tree is a directory of many small files, other kinds are single files
+GENERATED_KINDS = ["text", "logs", "numeric", "random", "tree"]
+TREE_FILES_COUNT = 1000
+
+
+class BenchmarkCase:
+    def __init__(self, name, directory, files):
+        self.name = name
+        self.directory = directory
+        self.files = files
+        self.raw_size = sum(os.path.getsize(os.path.join(directory, file)) for file in files)
+
+
+class ArchiverBenchmark:
+    class RunFailedException(Exception):
+        pass
+
+    def __init__(self, archiver_executable, archiver_args, iterations):
+        self.archiver_executable = archiver_executable
+        self.archiver_args = archiver_args
+        self.iterations = iterations
+
+    # Run archiver and return its wall time in seconds and peak resident memory in kilobytes. Memory is VmHWM, that
+    # archiver writes into its JSON report, so it's memory of archiver alone: rusage of child would never be less than
+    # memory of this script, because the kernel counts the forked process before exec
+    def run(self, args, cwd, report):
+        start = time.perf_counter()
+        process = subprocess.run([self.archiver_executable, "--report-json", report] + args, cwd=cwd,
+                                 stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        duration = time.perf_counter() - start
+        if process.returncode != 0:
+            raise ArchiverBenchmark.RunFailedException(
+                "archiver finished with exit code {code}".format(code=process.returncode))
+        with open(report) as report_file:
+            return duration, json.load(report_file)["peak_memory_bytes"] // 1024
+
+    def measure(self, case):
+        compress_times = []
+        decompress_times = []
+        peak_memory = 0
+        with tempfile.TemporaryDirectory() as work_dir:
+            archive = os.path.join(work_dir, "bench.arc")
+            output_dir = os.path.join(work_dir, "output")
+            report = os.path.join(work_dir, "report.json")
+            # The first iteration warms up caches and isn't measured
+            for iteration in range(self.iterations + 1):
+                if os.path.exists(archive):
+                    os.remove(archive)
+                duration, memory = self.run(self.archiver_args + ["-c", archive] + case.files, case.directory,
+                                            report)
+                if iteration > 0:
+                    compress_times.append(duration)
+                peak_memory = max(peak_memory, memory)
+
+                os.makedirs(output_dir, exist_ok=True)
+                duration, memory = self.run(["-d", archive], output_dir, report)
+                if iteration > 0:
+                    decompress_times.append(duration)
+                peak_memory = max(peak_memory, memory)
+                if iteration == 0:
+                    self.check_output(case, output_dir)
+                for file in os.listdir(output_dir):
+                    os.remove(os.path.join(output_dir, file))
+            archive_size = os.path.getsize(archive)
+
+        return {
+            "case": case.name,
+            "raw_bytes": case.raw_size,
+            "archive_bytes": archive_size,
+            "ratio": archive_size / case.raw_size if case.raw_size > 0 else 0,
+            "compress": throughput(case.raw_size, compress_times),
+            "decompress": throughput(case.raw_size, decompress_times),
+            "peak_memory_kb": peak_memory,
+        }
+
+    @staticmethod
+    def check_output(case, output_dir):
+        for file in case.files:
+            # Archive keeps only names of files, so files of tree are extracted into one directory
+            output_file = os.path.join(output_dir, os.path.basename(file))
+            if not filecmp.cmp(os.path.join(case.directory, file), output_file, shallow=False):
+                raise ArchiverBenchmark.RunFailedException("decompressed file {file} differs".format(file=file))
+
+
+# Mean and standard deviation of throughput in MB/s over iterations
+def throughput(size, durations):
+    speeds = [size / MEGABYTE / max(duration, 1e-9) for duration in durations]
+    return {
+        "mb_per_s": statistics.mean(speeds),
+        "stdev": statistics.stdev(speeds) if len(speeds) > 1 else 0,
+        "seconds": statistics.mean(durations),
+    }
+
+
+def generate(generator, kind, output, size, seed):
+    subprocess.run([generator, "--kind", kind, "--size", str(size // 1024), "--seed", str(seed), "--output", output,
+                    "--files", str(TREE_FILES_COUNT)], check=True)
+    if kind != "tree":
+        return [os.path.basename(output)]
+    return sorted(os.path.relpath(os.path.join(root, file), output)
+                  for root, _, files in os.walk(output) for file in files)
+
+
+def collect_cases(test_data_dir, generator, generated_dir, generated_size, seed):
+    cases = []
+    for name in sorted(os.listdir(test_data_dir)):
+        directory = os.path.join(test_data_dir, name)
+        if os.path.isdir(directory):
+            cases.append(BenchmarkCase(name, directory, sorted(os.listdir(directory))))
+    if generator is None:
+        return cases
+    for kind in GENERATED_KINDS:
+        output = os.path.join(generated_dir, kind + ".bin" if kind != "tree" else kind)
+        files = generate(generator, kind, output, generated_size, seed)
+        directory = output if kind == "tree" else generated_dir
+        cases.append(BenchmarkCase("generated_" + kind, directory, files))
+    return cases
+
+
+# Regression is a drop of throughput or a growth of peak memory over the relative threshold. Throughput also has to
+# drop by more than NOISE_SIGMAS combined standard deviations of both runs, so that noise of a busy machine isn't
+# reported as a regression. Throughput of runs shorter than MIN_COMPARED_SECONDS is mostly start of the process and
+# isn't compared
+NOISE_SIGMAS = 2
+MIN_COMPARED_SECONDS = 0.05
+
+
+def throughput_regression(direction, baseline, current, threshold):
+    if baseline["mb_per_s"] <= 0 or min(baseline["seconds"], current["seconds"]) < MIN_COMPARED_SECONDS:
+        return None
+    drop = (baseline["mb_per_s"] - current["mb_per_s"]) / baseline["mb_per_s"]
+    noise = NOISE_SIGMAS * (baseline["stdev"] ** 2 + current["stdev"] ** 2) ** 0.5 / baseline["mb_per_s"]
+    if drop <= max(threshold, noise):
+        return None
+    return "{direction} {old:.2f} -> {new:.2f} MB/s (-{drop:.1f}%, noise {noise:.1f}%)".format(
+        direction=direction, old=baseline["mb_per_s"], new=current["mb_per_s"], drop=drop * 100, noise=noise * 100)
+
+
+def memory_regression(baseline, current, threshold):
+    if baseline["peak_memory_kb"] <= 0:
+        return None
+    growth = (current["peak_memory_kb"] - baseline["peak_memory_kb"]) / baseline["peak_memory_kb"]
+    if growth <= threshold:
+        return None
+    return "memory {old} -> {new}KB (+{growth:.1f}%)".format(
+        old=baseline["peak_memory_kb"], new=current["peak_memory_kb"], growth=growth * 100)
+
+
+# Compare results with the baseline, print every regression and return whether there were any
+def compare(baseline, run, speed_threshold, memory_threshold):
+    for key in ["archiver_args", "size", "seed"]:
+        if baseline.get(key) != run[key]:
+            print("Warning: baseline was measured with {key} {value}".format(key=key, value=baseline.get(key)))
+    baseline_results = {result["case"]: result for result in baseline["results"]}
+    results = run["results"]
+    regressions = 0
+    for result in results:
+        if result["case"] not in baseline_results:
+            print("NEW  [{case}] not in baseline".format(case=result["case"]))
+            continue
+        old = baseline_results[result["case"]]
+        messages = [message for message in [
+            throughput_regression("compress", old["compress"], result["compress"], speed_threshold),
+            throughput_regression("decompress", old["decompress"], result["decompress"], speed_threshold),
+            memory_regression(old, result, memory_threshold)] if message is not None]
+        if messages:
+            regressions += 1
+            print("SLOW [{case}] {messages}".format(case=result["case"], messages="; ".join(messages)))
+        else:
+            print("OK   [{case}]".format(case=result["case"]))
+    print("{count} of {total} cases regressed".format(count=regressions, total=len(results)))
+    return regressions > 0
+
+
+def print_result(result):
+    print("{case:<20} {raw:>10.2f}MB  ratio {ratio:6.3f}  compress {c:8.2f} MB/s +- {c_dev:6.2f}  "
+          "decompress {d:8.2f} MB/s +- {d_dev:6.2f}  memory {memory:>8}KB".format(
+              case=result["case"], raw=result["raw_bytes"] / MEGABYTE, ratio=result["ratio"],
+              c=result["compress"]["mb_per_s"], c_dev=result["compress"]["stdev"],
+              d=result["decompress"]["mb_per_s"], d_dev=result["decompress"]["stdev"],
+              memory=result["peak_memory_kb"]), flush=True)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Measure throughput and ratio of archiver")
+    parser.add_argument("archiver", help="path to archiver executable")
+    parser.add_argument("data", help="directory with test cases, every subdirectory is one case")
+    parser.add_argument("--iterations", type=int, default=3, help="measured runs of every case")
+    parser.add_argument("--generator", help="path to generate_corpus executable, without it only data is measured")
+    parser.add_argument("--size", type=int, default=8, help="size of every generated input in megabytes")
+    parser.add_argument("--seed", type=int, default=1, help="seed of generated inputs")
+    parser.add_argument("--args", default="", help="archiver options for compression, e.g. --args=\"--indexed --bwt\"")
+    parser.add_argument("--json", help="also write results to this file, it can be used as a baseline later")
+    parser.add_argument("--baseline", help="compare results with results of --json of an earlier build, exit with 1 "
+                                           "if any case regressed")
+    parser.add_argument("--speed-threshold", type=float, default=5,
+                        help="percent of throughput drop, that is a regression (5 by default)")
+    parser.add_argument("--memory-threshold", type=float, default=10,
+                        help="percent of peak memory growth, that is a regression (10 by default)")
+    options = parser.parse_args()
+
+    baseline = None
+    if options.baseline:
+        with open(options.baseline) as baseline_file:
+            baseline = json.load(baseline_file)
+
+    benchmark = ArchiverBenchmark(os.path.abspath(options.archiver), shlex.split(options.args),
+                                  max(options.iterations, 1))
+    print("Running archiver benchmark\nExecutable: {executable}\nOptions: {args}\nIterations: {iterations}".format(
+        executable=benchmark.archiver_executable, args=options.args, iterations=benchmark.iterations))
+
+    results = []
+    with tempfile.TemporaryDirectory() as generated_dir:
+        cases = collect_cases(options.data, options.generator, generated_dir, options.size * MEGABYTE, options.seed)
+        for case in cases:
+            try:
+                result = benchmark.measure(case)
+            except ArchiverBenchmark.RunFailedException as e:
+                print("FAIL [{case}] {message}".format(case=case.name, message=e))
+                sys.exit(1)
+            print_result(result)
+            results.append(result)
+
+    run = {"archiver_args": options.args, "iterations": benchmark.iterations, "size": options.size,
+           "seed": options.seed, "results": results}
+    if options.json:
+        with open(options.json, "w") as output:
+            json.dump(run, output, indent=2)
+
+    if baseline is not None:
+        print("Comparing with baseline {path}".format(path=options.baseline))
+        if compare(baseline, run, options.speed_threshold / 100, options.memory_threshold / 100):
+            sys.exit(1)